@@ -0,0 +1,291 @@
+#include "ChangeFeed.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static const char* TYPE_NAMES[] = {
+    "add_student", "update_name", "update_age", "delete_student",
+    "add_course", "delete_course", "enroll", "grade"
+};
+static const int TYPE_COUNT = sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]);
+
+// How long the sink and the tail wait before looking for new changes.
+// The sink starts short and doubles its wait while nothing arrives.
+static const int SINK_MIN_IDLE_MS = 1;
+static const int SINK_MAX_IDLE_MS = 100;
+static const int TAIL_IDLE_MS = 100;
+
+string ChangeRecord::toLine() const {
+    ostringstream out;
+    out << seq << " " << (type >= 0 && type < TYPE_COUNT ? TYPE_NAMES[type] : "unknown")
+        << " " << rollNo << " " << value << " " << (code[0] ? code : "-");
+    return out.str();
+}
+
+bool ChangeRecord::fromLine(const string& line) {
+    istringstream in(line);
+    string typeName, codeText;
+    if(!(in >> seq >> typeName >> rollNo >> value >> codeText)) {
+        return false;
+    }
+    type = -1;
+    for(int i = 0; i < TYPE_COUNT; i++) {
+        if(typeName == TYPE_NAMES[i]) type = i;
+    }
+    memset(code, 0, sizeof(code));
+    if(codeText != "-") {
+        strncpy(code, codeText.c_str(), sizeof(code) - 1);
+    }
+    return type != -1;
+}
+
+// Constructor
+ChangeFeed::ChangeFeed(unsigned long long slotCount) {
+    capacity = 1;
+    while(capacity < slotCount) {
+        capacity <<= 1;
+    }
+    slots = new Slot[capacity];
+    for(unsigned long long i = 0; i < capacity; i++) {
+        slots[i].stamp.store(0, memory_order_relaxed);
+    }
+    nextSeq.store(1);
+    firstSeq.store(1);
+    enabled = true;
+    sinkStop.store(false);
+    sinkRunning.store(false);
+    sinkCursor.store(1);
+}
+
+// Destructor
+ChangeFeed::~ChangeFeed() {
+    stopFileSink();
+    delete[] slots;
+}
+
+void ChangeFeed::publish(ChangeType type, int rollNo, float value, const string& code) {
+    if(!enabled) {
+        return;
+    }
+    
+    ChangeRecord record;
+    memset(&record, 0, sizeof(record));
+    record.seq = nextSeq.fetch_add(1, memory_order_relaxed);
+    
+    // Wait while the slot holds a change the file sink has not taken yet
+    while(sinkRunning.load(memory_order_acquire) &&
+          record.seq >= sinkCursor.load(memory_order_acquire) + capacity) {
+        this_thread::yield();
+    }
+    record.type = type;
+    record.rollNo = rollNo;
+    record.value = value;
+    strncpy(record.code, code.c_str(), sizeof(record.code) - 1);
+    
+    unsigned long long words[RECORD_WORDS] = {};
+    memcpy(words, &record, sizeof(record));
+    
+    Slot& slot = slots[record.seq & (capacity - 1)];
+    slot.stamp.store(2 * record.seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for(int i = 0; i < RECORD_WORDS; i++) {
+        slot.words[i].store(words[i], memory_order_relaxed);
+    }
+    slot.stamp.store(2 * record.seq, memory_order_release);
+}
+
+ChangeFeed::ReadStatus ChangeFeed::read(unsigned long long seq, ChangeRecord& record) const {
+    if(seq < firstSeq.load(memory_order_acquire)) {
+        return READ_OVERWRITTEN;  // published by an earlier run, if at all
+    }
+    const Slot& slot = slots[seq & (capacity - 1)];
+    
+    unsigned long long before = slot.stamp.load(memory_order_acquire);
+    if(before != 2 * seq) {
+        return before > 2 * seq + 1 ? READ_OVERWRITTEN : READ_NOT_YET;
+    }
+    
+    unsigned long long words[RECORD_WORDS];
+    for(int i = 0; i < RECORD_WORDS; i++) {
+        words[i] = slot.words[i].load(memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if(slot.stamp.load(memory_order_relaxed) != before) {
+        return READ_OVERWRITTEN;  // a producer reused the slot while we copied
+    }
+    
+    memcpy(&record, words, sizeof(record));
+    return READ_OK;
+}
+
+unsigned long long ChangeFeed::lastSequence() const {
+    return nextSeq.load(memory_order_acquire) - 1;
+}
+
+unsigned long long ChangeFeed::oldestAvailable() const {
+    unsigned long long last = lastSequence();
+    unsigned long long oldest = last < capacity ? 1 : last - capacity + 1;
+    unsigned long long first = firstSeq.load(memory_order_acquire);
+    return oldest < first ? first : oldest;  // the ring starts empty each run
+}
+
+void ChangeFeed::setNextSequence(unsigned long long seq) {
+    firstSeq.store(seq);
+    nextSeq.store(seq);
+}
+
+void ChangeFeed::setEnabled(bool on) {
+    enabled = on;
+}
+
+// Last sequence number in an existing log file, 0 if none
+static unsigned long long lastLoggedSequence(string path) {
+    ifstream log(path.c_str());
+    string line, last;
+    while(getline(log, line)) {
+        if(!line.empty() && line[0] != '#') last = line;
+    }
+    ChangeRecord record;
+    return record.fromLine(last) ? record.seq : 0;
+}
+
+bool ChangeFeed::startFileSink(string path) {
+    if(sinkThread.joinable()) {
+        return false;  // one sink per feed
+    }
+    
+    // Only a regular file can be re-read to continue its numbering
+    struct stat info;
+    if(stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+        unsigned long long last = lastLoggedSequence(path);
+        if(last >= lastSequence()) {
+            setNextSequence(last + 1);
+        }
+    }
+    
+    sinkStop.store(false);
+    sinkCursor.store(lastSequence() + 1);
+    sinkRunning.store(true);
+    sinkThread = thread(&ChangeFeed::sinkLoop, this, path, lastSequence() + 1);
+    return true;
+}
+
+void ChangeFeed::stopFileSink() {
+    if(sinkThread.joinable()) {
+        sinkStop.store(true);
+        sinkThread.join();
+    }
+}
+
+// Write all of `data` to fd
+static bool writeAll(int fd, const string& data) {
+    size_t written = 0;
+    while(written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if(n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+void ChangeFeed::sinkLoop(string path, unsigned long long fromSeq) {
+    // Non-blocking open so a FIFO without a reader doesn't hang shutdown
+    int fd = -1;
+    int idleMs = SINK_MIN_IDLE_MS;
+    while(fd < 0) {
+        fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_NONBLOCK, 0644);
+        if(fd >= 0) {
+            break;
+        }
+        if(errno != ENXIO) {
+            cerr << "Error: cannot open change log " << path << endl;
+            sinkRunning.store(false);
+            return;
+        }
+        if(sinkStop.load()) {
+            sinkRunning.store(false);
+            return;  // no reader ever came
+        }
+        this_thread::sleep_for(chrono::milliseconds(idleMs));
+        idleMs = min(2 * idleMs, SINK_MAX_IDLE_MS);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    
+    string pending;
+    unsigned long long cursor = fromSeq;
+    idleMs = SINK_MIN_IDLE_MS;
+    while(true) {
+        ChangeRecord record;
+        ReadStatus status = read(cursor, record);
+        
+        if(status == READ_OK) {
+            pending += record.toLine();
+            pending += '\n';
+            cursor++;
+            sinkCursor.store(cursor, memory_order_release);  // the slot is free again
+            idleMs = SINK_MIN_IDLE_MS;
+            if(pending.size() < 64 * 1024) {
+                continue;
+            }
+        } else if(status == READ_OVERWRITTEN) {
+            unsigned long long oldest = oldestAvailable();
+            pending += "# missed " + to_string(cursor) + "-" + to_string(oldest - 1) + "\n";
+            cursor = oldest;
+            sinkCursor.store(cursor, memory_order_release);
+            continue;
+        }
+        
+        if(!pending.empty() && !writeAll(fd, pending)) {
+            cerr << "Error: change log " << path << " closed" << endl;
+            break;
+        }
+        pending.clear();
+        
+        if(status == READ_NOT_YET) {
+            if(sinkStop.load() && cursor > lastSequence()) {
+                break;
+            }
+            this_thread::sleep_for(chrono::milliseconds(idleMs));
+            idleMs = min(2 * idleMs, SINK_MAX_IDLE_MS);
+        }
+    }
+    sinkRunning.store(false);  // publishers no longer wait for this sink
+    close(fd);
+}
+
+int tailChangeLog(string path, unsigned long long fromSeq) {
+    ifstream log(path.c_str());
+    if(!log.is_open()) {
+        cerr << "Error: cannot open change log " << path << endl;
+        return 1;
+    }
+    
+    string line;
+    while(true) {
+        streampos start = log.tellg();
+        if(getline(log, line) && !log.eof()) {
+            ChangeRecord record;
+            if(line[0] == '#' || (record.fromLine(line) && record.seq >= fromSeq)) {
+                cout << line << endl;
+            }
+            continue;
+        }
+        
+        // End of what has been written so far: wait and read again.
+        // A line cut off without its newline is re-read once complete.
+        log.clear();
+        if(start != streampos(-1)) {
+            log.seekg(start);
+        }
+        this_thread::sleep_for(chrono::milliseconds(TAIL_IDLE_MS));
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include "Course.h"
+using namespace std;
+
+// Kinds of database changes
+enum ChangeType {
+    CHANGE_ADD_STUDENT,
+    CHANGE_UPDATE_NAME,
+    CHANGE_UPDATE_AGE,
+    CHANGE_DELETE_STUDENT,
+    CHANGE_ADD_COURSE,
+    CHANGE_DELETE_COURSE,
+    CHANGE_ENROLL,
+    CHANGE_GRADE
+};
+
+// One successful change. Only keys and numbers are carried; a consumer
+// that needs more (e.g. a new name) looks the student up.
+struct ChangeRecord {
+    unsigned long long seq;  // 1, 2, 3, ... in the order changes happened
+    int type;                // ChangeType
+    int rollNo;              // 0 for course changes
+    float value;             // age, credits or grade, depending on type
+    char code[Course::MAX_CODE_LENGTH + 1];  // course code, empty if none
+
+    string toLine() const;   // "<seq> <type name> <roll> <value> <code or ->"
+    bool fromLine(const string& line);
+};
+
+// Fixed-size ring of the most recent changes.
+//
+// Publishing takes no lock: a producer claims the next sequence number
+// and writes its slot, stamping the slot with that sequence before and
+// after. It only waits while a file sink is running and has not yet
+// written out the change the slot still holds, so the log is never lossy. Readers keep their own position and can
+// start from any sequence still in the ring; one that falls more than
+// a ring's length behind, or asks for a sequence from before this run,
+// sees READ_OVERWRITTEN and must skip ahead to oldestAvailable().
+class ChangeFeed {
+public:
+    enum ReadStatus { READ_OK, READ_NOT_YET, READ_OVERWRITTEN };
+
+private:
+    static const int RECORD_WORDS = (sizeof(ChangeRecord) + 7) / 8;
+
+    struct Slot {
+        atomic<unsigned long long> stamp;  // 2*seq when complete, 2*seq+1 while writing
+        atomic<unsigned long long> words[RECORD_WORDS];
+    };
+
+    Slot* slots;
+    unsigned long long capacity;  // power of two
+    atomic<unsigned long long> nextSeq;
+    atomic<unsigned long long> firstSeq;  // first sequence number of this run
+    bool enabled;
+
+    // Background copy of the feed into a file or FIFO
+    thread sinkThread;
+    atomic<bool> sinkStop;
+    atomic<bool> sinkRunning;
+    atomic<unsigned long long> sinkCursor;  // next sequence the sink will take
+    void sinkLoop(string path, unsigned long long fromSeq);
+
+public:
+    ChangeFeed(unsigned long long slotCount = 65536);
+    ~ChangeFeed();
+
+    void publish(ChangeType type, int rollNo, float value, const string& code);
+
+    ReadStatus read(unsigned long long seq, ChangeRecord& record) const;
+    unsigned long long lastSequence() const;     // 0 if nothing published yet
+    unsigned long long oldestAvailable() const;  // oldest sequence still in the ring
+
+    // Continue numbering after an earlier run (call before publishing)
+    void setNextSequence(unsigned long long seq);
+    void setEnabled(bool on);  // off: publish() does nothing
+
+    // Append every change to `path` as text lines from a background thread.
+    // An existing log is continued: numbering resumes after its last line.
+    // Publishers wait rather than overwrite changes the sink has not taken,
+    // so a FIFO without a reader stalls them after a ring's worth.
+    // For a FIFO, the program should ignore SIGPIPE so that a reader going
+    // away ends the sink (write fails with EPIPE) instead of the process.
+    bool startFileSink(string path);
+    void stopFileSink();  // writes out what is left, then returns
+};
+
+// Follow a change log written by startFileSink(), printing every record
+// with sequence >= fromSeq as it arrives. Never returns unless the file
+// cannot be opened.
+int tailChangeLog(string path, unsigned long long fromSeq);
+
+#endif
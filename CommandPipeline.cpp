@@ -0,0 +1,345 @@
+#include "CommandPipeline.h"
+#include <fstream>
+#include <sstream>
+
+// The parser stage blocks once this many commands are waiting to run
+static const size_t QUEUE_CAPACITY = 1024;
+
+Command::Command() {
+    type = CMD_INVALID;
+    rollNo = 0;
+    number = 0;
+    grade = 0;
+    seq = 0;
+}
+
+// Rest of the line with surrounding whitespace removed (used for names)
+static string restOfLine(istringstream& in) {
+    string rest;
+    getline(in, rest);
+    size_t first = rest.find_first_not_of(" \t");
+    if(first == string::npos) {
+        return "";
+    }
+    size_t last = rest.find_last_not_of(" \t\r");
+    return rest.substr(first, last - first + 1);
+}
+
+static bool invalid(Command& cmd, string reason) {
+    cmd.type = CMD_INVALID;
+    cmd.text = reason;
+    return true;
+}
+
+bool parseCommand(const string& line, Command& cmd) {
+    istringstream in(line);
+    string word;
+    
+    cmd = Command();
+    if(!(in >> word) || word[0] == '#') {
+        return false;  // blank line or comment
+    }
+    
+    if(word == "add") {
+        if(!(in >> cmd.rollNo >> cmd.number)) return invalid(cmd, "usage: add <roll> <age> <name>");
+        cmd.text = restOfLine(in);
+        if(cmd.text.empty()) return invalid(cmd, "usage: add <roll> <age> <name>");
+        cmd.type = CMD_ADD_STUDENT;
+    } else if(word == "delete") {
+        if(!(in >> cmd.rollNo)) return invalid(cmd, "usage: delete <roll>");
+        cmd.type = CMD_DELETE_STUDENT;
+    } else if(word == "update") {
+        string field;
+        if(!(in >> cmd.rollNo >> field)) return invalid(cmd, "usage: update <roll> name|age <value>");
+        if(field == "name") {
+            cmd.text = restOfLine(in);
+            if(cmd.text.empty()) return invalid(cmd, "usage: update <roll> name <name>");
+            cmd.type = CMD_UPDATE_NAME;
+        } else if(field == "age") {
+            if(!(in >> cmd.number)) return invalid(cmd, "usage: update <roll> age <age>");
+            cmd.type = CMD_UPDATE_AGE;
+        } else {
+            return invalid(cmd, "update field must be name or age");
+        }
+    } else if(word == "search") {
+        if(!(in >> cmd.rollNo)) return invalid(cmd, "usage: search <roll>");
+        cmd.type = CMD_SEARCH_STUDENT;
+    } else if(word == "list") {
+        cmd.type = CMD_LIST_STUDENTS;
+    } else if(word == "addcourse") {
+        if(!(in >> cmd.code >> cmd.number)) return invalid(cmd, "usage: addcourse <code> <credits> <name>");
+        cmd.text = restOfLine(in);
+        if(cmd.text.empty()) return invalid(cmd, "usage: addcourse <code> <credits> <name>");
+        cmd.type = CMD_ADD_COURSE;
+    } else if(word == "delcourse") {
+        if(!(in >> cmd.code)) return invalid(cmd, "usage: delcourse <code>");
+        cmd.type = CMD_DELETE_COURSE;
+    } else if(word == "courses") {
+        cmd.type = CMD_LIST_COURSES;
+    } else if(word == "report") {
+        if(!(in >> cmd.code)) return invalid(cmd, "usage: report <code>");
+        cmd.type = CMD_COURSE_REPORT;
+    } else if(word == "stats") {
+        if(!(in >> cmd.code)) return invalid(cmd, "usage: stats <code>");
+        cmd.type = CMD_COURSE_STATS;
+    } else if(word == "enroll") {
+        if(!(in >> cmd.rollNo >> cmd.code)) return invalid(cmd, "usage: enroll <roll> <code>");
+        cmd.type = CMD_ENROLL;
+    } else if(word == "grade") {
+        if(!(in >> cmd.rollNo >> cmd.code >> cmd.grade)) return invalid(cmd, "usage: grade <roll> <code> <grade>");
+        cmd.type = CMD_ADD_GRADE;
+    } else {
+        return invalid(cmd, "unknown command '" + word + "'");
+    }
+    return true;
+}
+
+bool isReadOnlyCommand(const Command& cmd) {
+    return cmd.type == CMD_INVALID ||
+           cmd.type == CMD_SEARCH_STUDENT ||
+           cmd.type == CMD_LIST_STUDENTS ||
+           cmd.type == CMD_LIST_COURSES ||
+           cmd.type == CMD_COURSE_REPORT ||
+           cmd.type == CMD_COURSE_STATS;
+}
+
+string formatCommand(const Command& cmd) {
+    ostringstream out;
+    switch(cmd.type) {
+        case CMD_ADD_STUDENT:    out << "add " << cmd.rollNo << " " << cmd.number << " " << cmd.text; break;
+        case CMD_DELETE_STUDENT: out << "delete " << cmd.rollNo; break;
+        case CMD_UPDATE_NAME:    out << "update " << cmd.rollNo << " name " << cmd.text; break;
+        case CMD_UPDATE_AGE:     out << "update " << cmd.rollNo << " age " << cmd.number; break;
+        case CMD_SEARCH_STUDENT: out << "search " << cmd.rollNo; break;
+        case CMD_LIST_STUDENTS:  out << "list"; break;
+        case CMD_ADD_COURSE:     out << "addcourse " << cmd.code << " " << cmd.number << " " << cmd.text; break;
+        case CMD_DELETE_COURSE:  out << "delcourse " << cmd.code; break;
+        case CMD_LIST_COURSES:   out << "courses"; break;
+        case CMD_COURSE_REPORT:  out << "report " << cmd.code; break;
+        case CMD_COURSE_STATS:   out << "stats " << cmd.code; break;
+        case CMD_ENROLL:         out << "enroll " << cmd.rollNo << " " << cmd.code; break;
+        case CMD_ADD_GRADE:      out << "grade " << cmd.rollNo << " " << cmd.code << " " << cmd.grade; break;
+        default: break;
+    }
+    return out.str();
+}
+
+string executeCommand(Database& db, const Command& cmd) {
+    ostringstream out;
+    
+    if(isReadOnlyCommand(cmd)) {
+        if(cmd.type == CMD_INVALID) {
+            out << "Error: " << cmd.text << endl;
+        } else if(cmd.type == CMD_SEARCH_STUDENT) {
+            out << db.renderStudent(cmd.rollNo);
+        } else if(cmd.type == CMD_COURSE_REPORT) {
+            out << db.renderCourseReport(cmd.code);
+        } else if(cmd.type == CMD_COURSE_STATS) {
+            // Stats line, then the course record; "none" if no such course
+            CourseStats stats;
+            if(db.getCourseStats(cmd.code, stats)) {
+                out << stats.serialize() << endl << db.searchCourse(cmd.code)->serialize() << endl;
+            } else {
+                out << "none" << endl;
+            }
+        } else if(cmd.type == CMD_LIST_STUDENTS) {
+            db.displayAllStudents(out);
+        } else {
+            db.displayAllCourses(out);
+        }
+        return out.str();
+    }
+    
+    switch(cmd.type) {
+        case CMD_ADD_STUDENT:    db.addStudent(cmd.rollNo, cmd.text, cmd.number, out); break;
+        case CMD_DELETE_STUDENT: db.deleteStudent(cmd.rollNo, out); break;
+        case CMD_UPDATE_NAME:    db.updateStudentName(cmd.rollNo, cmd.text, out); break;
+        case CMD_UPDATE_AGE:     db.updateStudentAge(cmd.rollNo, cmd.number, out); break;
+        case CMD_ADD_COURSE:     db.addCourse(cmd.code, cmd.text, cmd.number, out); break;
+        case CMD_DELETE_COURSE:  db.deleteCourse(cmd.code, out); break;
+        case CMD_ENROLL:         db.enrollStudentInCourse(cmd.rollNo, cmd.code, out); break;
+        case CMD_ADD_GRADE:      db.addGradeToStudent(cmd.rollNo, cmd.code, cmd.grade, out); break;
+        default: break;
+    }
+    return out.str();
+}
+
+// Constructor
+LocalExecutor::LocalExecutor(Database& database) : db(database) {
+}
+
+string LocalExecutor::execute(const Command& cmd) {
+    return executeCommand(db, cmd);
+}
+
+// Constructor
+CommandPipeline::CommandPipeline(CommandExecutor& commandExecutor, int workers, ostream& out)
+    : executor(commandExecutor), output(out.rdbuf()) {
+    workerCount = workers > 0 ? workers : 1;
+    nextSeq = 0;
+    openSources = 0;
+    readsInFlight = 0;
+    dispatchDone = false;
+    totalCommands = 0;
+    allQueued = false;
+}
+
+void CommandPipeline::addSource(string path) {
+    sources.push_back(path);
+}
+
+// Parser stage: one thread per input source
+void CommandPipeline::readSource(string path) {
+    ifstream file;
+    istream* in = &cin;
+    if(path != "-") {
+        file.open(path.c_str());  // blocks until a FIFO has a writer
+        in = &file;
+    }
+    
+    Command cmd;
+    if(path != "-" && !file.is_open()) {
+        invalid(cmd, "cannot open " + path);
+        enqueue(cmd);
+    } else {
+        string line;
+        while(getline(*in, line)) {
+            if(parseCommand(line, cmd)) {
+                enqueue(cmd);
+            }
+        }
+    }
+    
+    lock_guard<mutex> lock(queueMutex);
+    openSources--;
+    queueNotEmpty.notify_all();
+}
+
+void CommandPipeline::enqueue(Command& cmd) {
+    unique_lock<mutex> lock(queueMutex);
+    queueNotFull.wait(lock, [this] { return commandQueue.size() < QUEUE_CAPACITY; });
+    cmd.seq = nextSeq++;
+    commandQueue.push_back(cmd);
+    queueNotEmpty.notify_one();
+}
+
+// Worker pool: runs read-only commands, several at a time
+void CommandPipeline::workerLoop() {
+    while(true) {
+        Command cmd;
+        {
+            unique_lock<mutex> lock(readMutex);
+            readAvailable.wait(lock, [this] { return !readQueue.empty() || dispatchDone; });
+            if(readQueue.empty()) {
+                return;
+            }
+            cmd = readQueue.front();
+            readQueue.pop_front();
+        }
+        
+        pushResult(cmd.seq, executor.execute(cmd));
+        
+        lock_guard<mutex> lock(readMutex);
+        readsInFlight--;
+        if(readsInFlight == 0) {
+            readsFinished.notify_all();
+        }
+    }
+}
+
+void CommandPipeline::pushResult(long long seq, const string& text) {
+    lock_guard<mutex> lock(resultMutex);
+    results[seq] = text;
+    resultAvailable.notify_one();
+}
+
+// Output stage: prints results in the order the commands were queued
+void CommandPipeline::outputLoop() {
+    long long next = 0;
+    while(true) {
+        string text;
+        {
+            unique_lock<mutex> lock(resultMutex);
+            if(results.find(next) == results.end()) {
+                lock.unlock();
+                output.flush();  // nothing printable yet, push out what we have
+                lock.lock();
+            }
+            resultAvailable.wait(lock, [this, next] {
+                return results.find(next) != results.end() || (allQueued && next == totalCommands);
+            });
+            if(results.find(next) == results.end()) {
+                break;
+            }
+            text.swap(results[next]);
+            results.erase(next);
+        }
+        output << text;
+        next++;
+    }
+    output.flush();
+}
+
+// Dispatcher: runs on the calling thread until every source is drained
+long long CommandPipeline::run() {
+    openSources = sources.size();
+    
+    vector<thread> readers;
+    for(size_t i = 0; i < sources.size(); i++) {
+        readers.push_back(thread(&CommandPipeline::readSource, this, sources[i]));
+    }
+    vector<thread> workers;
+    for(int i = 0; i < workerCount; i++) {
+        workers.push_back(thread(&CommandPipeline::workerLoop, this));
+    }
+    thread printer(&CommandPipeline::outputLoop, this);
+    
+    while(true) {
+        Command cmd;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueNotEmpty.wait(lock, [this] { return !commandQueue.empty() || openSources == 0; });
+            if(commandQueue.empty()) {
+                break;
+            }
+            cmd = commandQueue.front();
+            commandQueue.pop_front();
+            queueNotFull.notify_one();
+        }
+        
+        if(isReadOnlyCommand(cmd)) {
+            lock_guard<mutex> lock(readMutex);
+            readQueue.push_back(cmd);
+            readsInFlight++;
+            readAvailable.notify_one();
+        } else {
+            // Wait for every earlier read, then run the mutation alone
+            unique_lock<mutex> lock(readMutex);
+            readsFinished.wait(lock, [this] { return readsInFlight == 0; });
+            lock.unlock();
+            pushResult(cmd.seq, executor.execute(cmd));
+        }
+    }
+    
+    {
+        lock_guard<mutex> lock(readMutex);
+        dispatchDone = true;
+        readAvailable.notify_all();
+    }
+    for(size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    for(size_t i = 0; i < readers.size(); i++) {
+        readers[i].join();
+    }
+    
+    {
+        lock_guard<mutex> lock(resultMutex);
+        allQueued = true;
+        totalCommands = nextSeq;
+        resultAvailable.notify_all();
+    }
+    printer.join();
+    
+    return totalCommands;
+}
@@ -0,0 +1,138 @@
+#ifndef COMMAND_PIPELINE_H
+#define COMMAND_PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Database.h"
+using namespace std;
+
+// One parsed line of a command script.
+//
+// Script syntax (one command per line, '#' starts a comment):
+//   add <roll> <age> <name...>       delete <roll>
+//   update <roll> name <name...>     update <roll> age <age>
+//   search <roll>                    list
+//   report <code>                    stats <code>   (report numbers, machine readable)
+//   addcourse <code> <credits> <name...>
+//   delcourse <code>                 courses
+//   enroll <roll> <code>             grade <roll> <code> <grade>
+enum CommandType {
+    CMD_INVALID,
+    CMD_ADD_STUDENT,
+    CMD_DELETE_STUDENT,
+    CMD_UPDATE_NAME,
+    CMD_UPDATE_AGE,
+    CMD_SEARCH_STUDENT,
+    CMD_LIST_STUDENTS,
+    CMD_ADD_COURSE,
+    CMD_DELETE_COURSE,
+    CMD_LIST_COURSES,
+    CMD_COURSE_REPORT,
+    CMD_COURSE_STATS,
+    CMD_ENROLL,
+    CMD_ADD_GRADE
+};
+
+struct Command {
+    CommandType type;
+    int rollNo;
+    int number;      // age or credits
+    float grade;
+    string code;     // course code
+    string text;     // name, or the error message for CMD_INVALID
+    long long seq;   // position in the execution queue
+
+    Command();
+};
+
+// Parse one script line. Returns false for blank and comment lines;
+// malformed lines come back as CMD_INVALID with the reason in text.
+bool parseCommand(const string& line, Command& cmd);
+
+// Commands that only read the database may run at the same time
+bool isReadOnlyCommand(const Command& cmd);
+
+// Turn a parsed command back into a script line
+string formatCommand(const Command& cmd);
+
+// Run a command and return everything it would have printed
+string executeCommand(Database& db, const Command& cmd);
+
+// Something that can run commands: a local database or a shard router.
+// execute() may be called for read-only commands from several threads.
+class CommandExecutor {
+public:
+    virtual ~CommandExecutor() {}
+    virtual string execute(const Command& cmd) = 0;
+};
+
+// Runs commands against a Database in this process
+class LocalExecutor : public CommandExecutor {
+private:
+    Database& db;
+
+public:
+    LocalExecutor(Database& database);
+    string execute(const Command& cmd);
+};
+
+// Runs scripted commands as three stages:
+//   - one reader thread per source parses lines into the execution queue
+//   - the dispatcher hands read-only commands to a worker pool and runs
+//     each mutation alone, after every earlier command has finished
+//   - the output stage prints results in queue order
+// Mutations therefore never overlap anything, and every command sees
+// the effects of all commands queued before it.
+class CommandPipeline {
+private:
+    CommandExecutor& executor;
+    ostream output;  // bound to the caller's stream buffer, not to cout itself
+    int workerCount;
+    vector<string> sources;
+
+    // Parser stage -> dispatcher
+    deque<Command> commandQueue;
+    long long nextSeq;
+    int openSources;
+    mutex queueMutex;
+    condition_variable queueNotEmpty;
+    condition_variable queueNotFull;
+
+    // Dispatcher -> worker pool
+    deque<Command> readQueue;
+    int readsInFlight;
+    bool dispatchDone;
+    mutex readMutex;
+    condition_variable readAvailable;
+    condition_variable readsFinished;
+
+    // Execution -> output stage
+    map<long long, string> results;
+    long long totalCommands;
+    bool allQueued;
+    mutex resultMutex;
+    condition_variable resultAvailable;
+
+    void readSource(string path);
+    void enqueue(Command& cmd);
+    void workerLoop();
+    void outputLoop();
+    void pushResult(long long seq, const string& text);
+
+public:
+    CommandPipeline(CommandExecutor& commandExecutor, int workers, ostream& out = cout);
+
+    // "-" reads standard input; files and FIFOs are read line by line
+    void addSource(string path);
+
+    // Process every source to the end; returns the number of commands run
+    long long run();
+};
+
+#endif
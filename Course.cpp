@@ -30,11 +30,11 @@ int Course::getCredits() const {
 }
 
 // Display course information
-void Course::displayCourseInfo() const {
-    cout << "Course Code: " << courseCode << endl;
-    cout << "Course Name: " << courseName << endl;
-    cout << "Credits: " << credits << endl;
-    cout << "--------------------------------" << endl;
+void Course::displayCourseInfo(ostream& out) const {
+    out << "Course Code: " << courseCode << endl;
+    out << "Course Name: " << courseName << endl;
+    out << "Credits: " << credits << endl;
+    out << "--------------------------------" << endl;
 }
 
 // Convert course data to string for file storage
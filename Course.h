@@ -2,6 +2,7 @@
 #define COURSE_H
 
 #include <string>
+#include <iostream>
 using namespace std;
 
 class Course {
@@ -11,6 +12,9 @@ private:
     int credits;
 
 public:
+    // Longest course code accepted, so change records carry it whole
+    static const size_t MAX_CODE_LENGTH = 31;
+    
     // Constructors
     Course();
     Course(string code, string name, int credit);
@@ -21,7 +25,7 @@ public:
     int getCredits() const;
     
     // Display method
-    void displayCourseInfo() const;
+    void displayCourseInfo(ostream& out = cout) const;
     
     // For file operations
     string serialize() const;
@@ -1,22 +1,73 @@
 #include "Database.h"
+#include "Snapshot.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <utility>
+
+// Default memory budget for cached query results
+static const size_t DEFAULT_CACHE_BYTES = 4 * 1024 * 1024;
+
+// Empty aggregates
+CourseStats::CourseStats() {
+    enrolled = 0;
+    graded = 0;
+    gradeTotal = 0;
+    gpaTotal = 0;
+    highest = 0;
+    lowest = 10;
+}
+
+// Combine aggregates of two disjoint sets of students
+void CourseStats::merge(const CourseStats& other) {
+    enrolled += other.enrolled;
+    graded += other.graded;
+    gradeTotal += other.gradeTotal;
+    gpaTotal += other.gpaTotal;
+    highest = max(highest, other.highest);
+    lowest = min(lowest, other.lowest);
+}
+
+string CourseStats::serialize() const {
+    ostringstream out;
+    out << setprecision(9) << enrolled << " " << graded << " " << gradeTotal << " "
+        << gpaTotal << " " << highest << " " << lowest;
+    return out.str();
+}
+
+void CourseStats::deserialize(string data) {
+    istringstream in(data);
+    in >> enrolled >> graded >> gradeTotal >> gpaTotal >> highest >> lowest;
+}
 
 // Constructor
-Database::Database() {
+Database::Database() : cache(DEFAULT_CACHE_BYTES) {
+    compressedStorage = false;
+    autoSave = true;
+    
     // Load existing data when program starts
     loadFromFile();
 }
 
 // Helper function to find student by roll number
 int Database::findStudentIndex(int rollNo) {
-    for(int i = 0; i < students.size(); i++) {
-        if(students[i].getRollNo() == rollNo) {
-            return i;
-        }
+    auto it = rollIndex.find(rollNo);
+    if(it == rollIndex.end()) {
+        return -1;  // Not found
+    }
+    return it->second;
+}
+
+// Map every roll number to its position (the first one wins on duplicates)
+void Database::rebuildRollIndex() {
+    rollIndex.clear();
+    rollIndex.reserve(students.size());
+    for(size_t i = 0; i < students.size(); i++) {
+        rollIndex.insert(make_pair(students[i].getRollNo(), (int)i));
     }
-    return -1;  // Not found
 }
 
 // Helper function to find course by code
@@ -29,32 +80,65 @@ int Database::findCourseIndex(string courseCode) {
     return -1;  // Not found
 }
 
+// Whether all of a student's course codes are short enough to be valid
+static bool courseCodesFit(const Student& s) {
+    const vector<string>& taken = s.getCourses();
+    for(size_t i = 0; i < taken.size(); i++) {
+        if(taken[i].size() > Course::MAX_CODE_LENGTH) return false;
+    }
+    const map<string, float>& grades = s.getGrades();
+    for(auto it = grades.begin(); it != grades.end(); it++) {
+        if(it->first.size() > Course::MAX_CODE_LENGTH) return false;
+    }
+    return true;
+}
+
+// Cached student views and course reports that include this student
+void Database::invalidateStudent(const Student& s) {
+    cache.invalidate("S:" + to_string(s.getRollNo()));
+    
+    // Course reports show enrollment counts, grades and GPAs
+    const vector<string>& enrolled = s.getCourses();
+    for(size_t i = 0; i < enrolled.size(); i++) {
+        cache.invalidate("C:" + enrolled[i]);
+    }
+    const map<string, float>& grades = s.getGrades();
+    for(auto it = grades.begin(); it != grades.end(); it++) {
+        cache.invalidate("C:" + it->first);
+    }
+}
+
 // Add a new student to the database
-void Database::addStudent(int rollNo, string name, int age) {
+void Database::addStudent(int rollNo, string name, int age, ostream& out) {
     // Check if student already exists
     if(findStudentIndex(rollNo) != -1) {
-        cout << "Error: Student with Roll No " << rollNo << " already exists!" << endl;
+        out << "Error: Student with Roll No " << rollNo << " already exists!" << endl;
         return;
     }
     
     Student newStudent(rollNo, name, age);
     students.push_back(newStudent);
-    cout << "Student added successfully!" << endl;
-    saveToFile();  // Save after adding
+    rollIndex[rollNo] = students.size() - 1;
+    out << "Student added successfully!" << endl;
+    changes.publish(CHANGE_ADD_STUDENT, rollNo, age, "");
+    if(autoSave) saveToFile();  // Save after adding
 }
 
 // Delete a student from database
-void Database::deleteStudent(int rollNo) {
+void Database::deleteStudent(int rollNo, ostream& out) {
     int index = findStudentIndex(rollNo);
     
     if(index == -1) {
-        cout << "Error: Student with Roll No " << rollNo << " not found!" << endl;
+        out << "Error: Student with Roll No " << rollNo << " not found!" << endl;
         return;
     }
     
+    invalidateStudent(students[index]);
     students.erase(students.begin() + index);
-    cout << "Student deleted successfully!" << endl;
-    saveToFile();  // Save after deleting
+    rebuildRollIndex();  // later students moved down by one
+    out << "Student deleted successfully!" << endl;
+    changes.publish(CHANGE_DELETE_STUDENT, rollNo, 0, "");
+    if(autoSave) saveToFile();  // Save after deleting
 }
 
 // Update student information
@@ -79,20 +163,47 @@ void Database::updateStudent(int rollNo) {
         string newName;
         cout << "Enter new name: ";
         getline(cin, newName);
-        students[index].setName(newName);
-        cout << "Name updated successfully!" << endl;
+        updateStudentName(rollNo, newName);
     } else if(choice == 2) {
         int newAge;
         cout << "Enter new age: ";
         cin >> newAge;
-        students[index].setAge(newAge);
-        cout << "Age updated successfully!" << endl;
+        updateStudentAge(rollNo, newAge);
     } else {
         cout << "Invalid choice!" << endl;
+    }
+}
+
+// Change a student's name without prompting
+void Database::updateStudentName(int rollNo, string newName, ostream& out) {
+    int index = findStudentIndex(rollNo);
+    
+    if(index == -1) {
+        out << "Error: Student with Roll No " << rollNo << " not found!" << endl;
         return;
     }
     
-    saveToFile();  // Save after updating
+    students[index].setName(newName);
+    cache.invalidate("S:" + to_string(rollNo));
+    out << "Name updated successfully!" << endl;
+    changes.publish(CHANGE_UPDATE_NAME, rollNo, 0, "");
+    if(autoSave) saveToFile();  // Save after updating
+}
+
+// Change a student's age without prompting
+void Database::updateStudentAge(int rollNo, int newAge, ostream& out) {
+    int index = findStudentIndex(rollNo);
+    
+    if(index == -1) {
+        out << "Error: Student with Roll No " << rollNo << " not found!" << endl;
+        return;
+    }
+    
+    students[index].setAge(newAge);
+    cache.invalidate("S:" + to_string(rollNo));
+    out << "Age updated successfully!" << endl;
+    changes.publish(CHANGE_UPDATE_AGE, rollNo, newAge, "");
+    if(autoSave) saveToFile();  // Save after updating
 }
 
 // Search for a student
@@ -106,45 +217,222 @@ Student* Database::searchStudent(int rollNo) {
     return &students[index];
 }
 
+// Add a batch of students in one pass
+int Database::bulkAddStudents(vector<Student>& batch, bool finish) {
+    // One sort of (roll number, position) pairs, skipped when the batch is
+    // already in roll order. Ties keep batch order, so the first record of
+    // a repeated roll number is the one added.
+    vector<pair<int, int> > order(batch.size());
+    for(size_t i = 0; i < batch.size(); i++) {
+        order[i] = make_pair(batch[i].getRollNo(), (int)i);
+    }
+    if(!is_sorted(order.begin(), order.end())) {
+        sort(order.begin(), order.end());
+    }
+    
+    students.reserve(students.size() + batch.size());
+    rollIndex.reserve(students.size() + batch.size());
+    int added = 0;
+    for(size_t k = 0; k < order.size(); k++) {
+        int rollNo = order[k].first;
+        int i = order[k].second;
+        if(k > 0 && order[k - 1].first == rollNo) {
+            continue;  // repeated in the batch
+        }
+        if(rollIndex.count(rollNo)) {
+            continue;  // already in the database
+        }
+        if(!courseCodesFit(batch[i])) {
+            continue;  // a course code addCourse() would refuse
+        }
+        
+        // Drop repeated course codes, keeping the first occurrence
+        const vector<string>& taken = batch[i].getCourses();
+        vector<string> sorted = taken;
+        sort(sorted.begin(), sorted.end());
+        if(adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            vector<string> distinct;
+            for(size_t c = 0; c < taken.size(); c++) {
+                if(find(distinct.begin(), distinct.end(), taken[c]) == distinct.end()) {
+                    distinct.push_back(taken[c]);
+                }
+            }
+            batch[i].setCourses(distinct);
+        }
+        
+        students.push_back(move(batch[i]));
+        rollIndex.insert(make_pair(rollNo, (int)students.size() - 1));
+        const Student& s = students.back();
+        changes.publish(CHANGE_ADD_STUDENT, rollNo, s.getAge(), "");
+        for(size_t c = 0; c < s.getCourses().size(); c++) {
+            changes.publish(CHANGE_ENROLL, rollNo, 0, s.getCourses()[c]);
+        }
+        for(auto it = s.getGrades().begin(); it != s.getGrades().end(); it++) {
+            changes.publish(CHANGE_GRADE, rollNo, it->second, it->first);
+        }
+        added++;
+    }
+    
+    if(finish) {
+        finishBulkLoad();
+    }
+    return added;
+}
+
+// End of a bulk load made of several batches
+void Database::finishBulkLoad() {
+    cache.clear();  // course reports may now include the new students
+    saveToFile();
+}
+
 // Display all students
-void Database::displayAllStudents() {
+void Database::displayAllStudents(ostream& out) {
     if(students.empty()) {
-        cout << "\nNo students in the database!" << endl;
+        out << "\nNo students in the database!" << endl;
         return;
     }
     
-    cout << "\n========== ALL STUDENTS ==========" << endl;
+    out << "\n========== ALL STUDENTS ==========" << endl;
     for(int i = 0; i < students.size(); i++) {
-        students[i].displayInfo();
+        students[i].displayInfo(out);
     }
 }
 
+// Student details as displayInfo() prints them, cached by roll number
+string Database::renderStudent(int rollNo) {
+    string key = "S:" + to_string(rollNo);
+    string view;
+    if(cache.get(key, view)) {
+        return view;
+    }
+    
+    int index = findStudentIndex(rollNo);
+    if(index == -1) {
+        return "Student not found!\n";
+    }
+    
+    ostringstream out;
+    students[index].displayInfo(out);
+    view = out.str();
+    cache.put(key, view);
+    return view;
+}
+
+// Enrollment and grade summary for one course, cached by course code
+string Database::renderCourseReport(string courseCode) {
+    string key = "C:" + courseCode;
+    string report;
+    if(cache.get(key, report)) {
+        return report;
+    }
+    
+    int courseIndex = findCourseIndex(courseCode);
+    if(courseIndex == -1) {
+        return "Course not found!\n";
+    }
+    
+    CourseStats stats;
+    getCourseStats(courseCode, stats);
+    report = formatCourseReport(courses[courseIndex], stats);
+    cache.put(key, report);
+    return report;
+}
+
+// Collect the aggregates shown in a course report
+bool Database::getCourseStats(string courseCode, CourseStats& stats) {
+    if(findCourseIndex(courseCode) == -1) {
+        return false;
+    }
+    
+    for(size_t i = 0; i < students.size(); i++) {
+        const vector<string>& taken = students[i].getCourses();
+        if(find(taken.begin(), taken.end(), courseCode) != taken.end()) {
+            stats.enrolled++;
+            stats.gpaTotal += students[i].calculateGPA();
+        }
+        
+        const map<string, float>& grades = students[i].getGrades();
+        auto it = grades.find(courseCode);
+        if(it != grades.end()) {
+            stats.graded++;
+            stats.gradeTotal += it->second;
+            stats.highest = max(stats.highest, it->second);
+            stats.lowest = min(stats.lowest, it->second);
+        }
+    }
+    return true;
+}
+
+// Text of a course report, as shown on screen
+string Database::formatCourseReport(const Course& course, const CourseStats& stats) {
+    ostringstream out;
+    out << "\n========== COURSE REPORT ==========" << endl;
+    course.displayCourseInfo(out);
+    out << "Enrolled Students: " << stats.enrolled << endl;
+    out << "Graded Students: " << stats.graded << endl;
+    out << fixed << setprecision(2);
+    if(stats.graded > 0) {
+        out << "Average Grade: " << stats.gradeTotal / stats.graded << endl;
+        out << "Highest Grade: " << stats.highest << endl;
+        out << "Lowest Grade: " << stats.lowest << endl;
+    }
+    if(stats.enrolled > 0) {
+        out << "Average GPA of Enrolled Students: " << stats.gpaTotal / stats.enrolled << endl;
+    }
+    out << "===================================" << endl;
+    return out.str();
+}
+
+void Database::setCacheBudget(size_t bytes) {
+    cache.setBudget(bytes);
+}
+
+// Show how well the query cache is doing
+void Database::displayCacheStats(ostream& out) {
+    long long hits = cache.getHits();
+    long long misses = cache.getMisses();
+    out << "Cache hits: " << hits << ", misses: " << misses;
+    if(hits + misses > 0) {
+        out << " (" << fixed << setprecision(1) << 100.0 * hits / (hits + misses) << "% hit rate)";
+    }
+    out << ", memory used: " << cache.getUsedBytes() << " bytes" << endl;
+}
+
 // Add a new course
-void Database::addCourse(string code, string name, int credits) {
+void Database::addCourse(string code, string name, int credits, ostream& out) {
+    if(code.size() > Course::MAX_CODE_LENGTH) {
+        out << "Error: Course code must be at most " << Course::MAX_CODE_LENGTH << " characters!" << endl;
+        return;
+    }
+    
     // Check if course already exists
     if(findCourseIndex(code) != -1) {
-        cout << "Error: Course with code " << code << " already exists!" << endl;
+        out << "Error: Course with code " << code << " already exists!" << endl;
         return;
     }
     
     Course newCourse(code, name, credits);
     courses.push_back(newCourse);
-    cout << "Course added successfully!" << endl;
-    saveToFile();
+    cache.invalidate("C:" + code);
+    out << "Course added successfully!" << endl;
+    changes.publish(CHANGE_ADD_COURSE, 0, credits, code);
+    if(autoSave) saveToFile();
 }
 
 // Delete a course
-void Database::deleteCourse(string courseCode) {
+void Database::deleteCourse(string courseCode, ostream& out) {
     int index = findCourseIndex(courseCode);
     
     if(index == -1) {
-        cout << "Error: Course with code " << courseCode << " not found!" << endl;
+        out << "Error: Course with code " << courseCode << " not found!" << endl;
         return;
     }
     
     courses.erase(courses.begin() + index);
-    cout << "Course deleted successfully!" << endl;
-    saveToFile();
+    cache.invalidate("C:" + courseCode);
+    out << "Course deleted successfully!" << endl;
+    changes.publish(CHANGE_DELETE_COURSE, 0, 0, courseCode);
+    if(autoSave) saveToFile();
 }
 
 // Search for a course
@@ -159,66 +447,84 @@ Course* Database::searchCourse(string courseCode) {
 }
 
 // Display all courses
-void Database::displayAllCourses() {
+void Database::displayAllCourses(ostream& out) {
     if(courses.empty()) {
-        cout << "\nNo courses available!" << endl;
+        out << "\nNo courses available!" << endl;
         return;
     }
     
-    cout << "\n========== ALL COURSES ==========" << endl;
+    out << "\n========== ALL COURSES ==========" << endl;
     for(int i = 0; i < courses.size(); i++) {
-        courses[i].displayCourseInfo();
+        courses[i].displayCourseInfo(out);
     }
 }
 
 // Enroll a student in a course
-void Database::enrollStudentInCourse(int rollNo, string courseCode) {
+void Database::enrollStudentInCourse(int rollNo, string courseCode, ostream& out) {
     // Check if student exists
     int studentIndex = findStudentIndex(rollNo);
     if(studentIndex == -1) {
-        cout << "Error: Student not found!" << endl;
+        out << "Error: Student not found!" << endl;
         return;
     }
     
     // Check if course exists
     if(findCourseIndex(courseCode) == -1) {
-        cout << "Error: Course not found!" << endl;
+        out << "Error: Course not found!" << endl;
         return;
     }
     
-    students[studentIndex].addCourse(courseCode);
-    saveToFile();
+    if(!students[studentIndex].addCourse(courseCode, out)) {
+        return;  // already enrolled, nothing changed
+    }
+    changes.publish(CHANGE_ENROLL, rollNo, 0, courseCode);
+    cache.invalidate("S:" + to_string(rollNo));
+    cache.invalidate("C:" + courseCode);
+    if(autoSave) saveToFile();
 }
 
 // Add grade to a student for a course
-void Database::addGradeToStudent(int rollNo, string courseCode, float grade) {
+void Database::addGradeToStudent(int rollNo, string courseCode, float grade, ostream& out) {
     int studentIndex = findStudentIndex(rollNo);
     
     if(studentIndex == -1) {
-        cout << "Error: Student not found!" << endl;
+        out << "Error: Student not found!" << endl;
         return;
     }
     
-    students[studentIndex].addGrade(courseCode, grade);
-    saveToFile();
+    if(!students[studentIndex].addGrade(courseCode, grade, out)) {
+        return;  // invalid grade, nothing changed
+    }
+    changes.publish(CHANGE_GRADE, rollNo, grade, courseCode);
+    invalidateStudent(students[studentIndex]);  // GPA changes on all its courses
+    if(autoSave) saveToFile();
 }
 
 // Save all data to files
 void Database::saveToFile() {
-    // Save students
-    ofstream studentFile("students.txt");
-    if(studentFile.is_open()) {
-        for(int i = 0; i < students.size(); i++) {
-            studentFile << students[i].serialize() << endl;
+    // Save students, removing the other format so only one copy exists
+    if(compressedStorage) {
+        if(Snapshot::save(students, "students.dat")) {
+            remove("students.txt");
+        } else {
+            cout << "Error: Could not write students.dat!" << endl;
+        }
+    } else {
+        ofstream studentFile("students.txt");
+        if(studentFile.is_open()) {
+            for(int i = 0; i < students.size(); i++) {
+                studentFile << students[i].serialize() << '\n';
+            }
+            studentFile.close();
+            remove("students.dat");
         }
-        studentFile.close();
     }
     
     // Save courses
     ofstream courseFile("courses.txt");
     if(courseFile.is_open()) {
         for(int i = 0; i < courses.size(); i++) {
-            courseFile << courses[i].serialize() << endl;
+            courseFile << courses[i].serialize() << '\n';
         }
         courseFile.close();
     }
@@ -226,9 +532,27 @@ void Database::saveToFile() {
 
 // Load data from files
 void Database::loadFromFile() {
-    // Load students
+    cache.clear();
+    
+    // Load students (a compressed snapshot takes priority and keeps
+    // the database in compressed mode)
+    bool recovered = false;
+    ifstream snapshotFile("students.dat");
+    if(snapshotFile.is_open()) {
+        snapshotFile.close();
+        compressedStorage = true;
+        if(!Snapshot::load("students.dat", students)) {
+            // Keep what could be read, and set the damaged file aside so
+            // the save below cannot overwrite the rest of its data
+            rename("students.dat", "students.dat.damaged");
+            cout << "Error: students.dat is damaged! Recovered " << students.size()
+                 << " students; the original was kept as students.dat.damaged" << endl;
+            recovered = true;
+        }
+    }
+    
     ifstream studentFile("students.txt");
-    if(studentFile.is_open()) {
+    if(!compressedStorage && studentFile.is_open()) {
         string line;
         while(getline(studentFile, line)) {
             if(!line.empty()) {
@@ -240,6 +564,8 @@ void Database::loadFromFile() {
         studentFile.close();
     }
     
+    rebuildRollIndex();
+    
     // Load courses
     ifstream courseFile("courses.txt");
     if(courseFile.is_open()) {
@@ -253,4 +579,28 @@ void Database::loadFromFile() {
         }
         courseFile.close();
     }
+    
+    // Write the recovered students out at once, so they survive a run
+    // that changes nothing
+    if(recovered) {
+        saveToFile();
+    }
+}
+
+// Choose the storage format used by the next save
+void Database::setCompressedStorage(bool enabled) {
+    compressedStorage = enabled;
+}
+
+bool Database::isCompressedStorage() const {
+    return compressedStorage;
+}
+
+ChangeFeed& Database::getChangeFeed() {
+    return changes;
+}
+
+// Turn off to keep changes in memory until saveToFile() is called
+void Database::setAutoSave(bool enabled) {
+    autoSave = enabled;
 }
@@ -2,42 +2,97 @@
 #define DATABASE_H
 
 #include <vector>
+#include <unordered_map>
 #include "Student.h"
 #include "Course.h"
+#include "QueryCache.h"
+#include "ChangeFeed.h"
+
+// Per-course aggregates behind a course report. Stats from separate
+// databases (e.g. shards) can be merged before formatting.
+struct CourseStats {
+    int enrolled;
+    int graded;
+    float gradeTotal;
+    float gpaTotal;    // sum of GPAs of enrolled students
+    float highest;
+    float lowest;
+    
+    CourseStats();
+    void merge(const CourseStats& other);
+    string serialize() const;
+    void deserialize(string data);
+};
 
 class Database {
 private:
     vector<Student> students;
     vector<Course> courses;
+    bool compressedStorage;  // students.dat instead of students.txt
+    bool autoSave;  // save after every change
+    QueryCache cache;  // rendered student views and course reports
+    unordered_map<int, int> rollIndex;  // roll number -> position in students
+    ChangeFeed changes;  // every successful change, in order
     
     // Helper function to find student index
     int findStudentIndex(int rollNo);
     int findCourseIndex(string courseCode);
+    void rebuildRollIndex();
+    
+    // Drop cached results that show this student's data
+    void invalidateStudent(const Student& s);
 
 public:
     // Constructor
     Database();
     
     // Student operations
-    void addStudent(int rollNo, string name, int age);
-    void deleteStudent(int rollNo);
-    void updateStudent(int rollNo);
+    void addStudent(int rollNo, string name, int age, ostream& out = cout);
+    void deleteStudent(int rollNo, ostream& out = cout);
+    void updateStudent(int rollNo);  // asks what to change on the console
+    void updateStudentName(int rollNo, string newName, ostream& out = cout);
+    void updateStudentAge(int rollNo, int newAge, ostream& out = cout);
     Student* searchStudent(int rollNo);
-    void displayAllStudents();
+    
+    // Add many students at once: no console output, one sort for duplicates,
+    // only the new records added to the index. Records whose roll number is
+    // already taken (or repeated in the batch), or with a course code longer
+    // than Course::MAX_CODE_LENGTH, are skipped. Returns how many
+    // were added. The change feed gets an add_student per student, followed
+    // by its enrollments and grades. When loading in several batches, pass
+    // finish = false and call finishBulkLoad() after the last one; queries
+    // in between may see stale course reports.
+    int bulkAddStudents(vector<Student>& batch, bool finish = true);
+    void finishBulkLoad();  // drop cached reports and save once
+    void displayAllStudents(ostream& out = cout);
     
     // Course operations
-    void addCourse(string code, string name, int credits);
-    void deleteCourse(string courseCode);
+    void addCourse(string code, string name, int credits, ostream& out = cout);
+    void deleteCourse(string courseCode, ostream& out = cout);
     Course* searchCourse(string courseCode);
-    void displayAllCourses();
+    void displayAllCourses(ostream& out = cout);
+    
+    // Cached queries (safe to call from several threads at once)
+    string renderStudent(int rollNo);
+    string renderCourseReport(string courseCode);
+    bool getCourseStats(string courseCode, CourseStats& stats);  // false if no such course
+    static string formatCourseReport(const Course& course, const CourseStats& stats);
+    void setCacheBudget(size_t bytes);  // 0 turns the cache off
+    void displayCacheStats(ostream& out = cout);
     
     // Enrollment operations
-    void enrollStudentInCourse(int rollNo, string courseCode);
-    void addGradeToStudent(int rollNo, string courseCode, float grade);
+    void enrollStudentInCourse(int rollNo, string courseCode, ostream& out = cout);
+    void addGradeToStudent(int rollNo, string courseCode, float grade, ostream& out = cout);
     
     // File operations
     void saveToFile();
     void loadFromFile();
+    void setCompressedStorage(bool enabled);
+    bool isCompressedStorage() const;
+    void setAutoSave(bool enabled);
+    
+    // Change data capture: tail in-process or start a file/FIFO sink
+    ChangeFeed& getChangeFeed();
 };
 
 #endif
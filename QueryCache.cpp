@@ -0,0 +1,103 @@
+#include "QueryCache.h"
+
+// Rough cost of the list node, hash node and string headers of one entry
+static const size_t ENTRY_OVERHEAD = 128;
+
+// Constructor
+QueryCache::QueryCache(size_t budgetBytes) {
+    budget = budgetBytes;
+    used = 0;
+    hits = 0;
+    misses = 0;
+}
+
+size_t QueryCache::entryCost(const string& key, const string& value) {
+    return key.size() + value.size() + ENTRY_OVERHEAD;
+}
+
+// Drop least recently used entries until we fit in the budget
+void QueryCache::evictToBudget() {
+    while(used > budget && !entries.empty()) {
+        Entry& last = entries.back();
+        used -= entryCost(last.key, last.value);
+        index.erase(last.key);
+        entries.pop_back();
+    }
+}
+
+// Look up a key; a hit moves the entry to the front
+bool QueryCache::get(const string& key, string& value) {
+    lock_guard<mutex> guard(lock);
+    auto it = index.find(key);
+    if(it == index.end()) {
+        misses++;
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    value = it->second->value;
+    hits++;
+    return true;
+}
+
+// Add or replace an entry
+void QueryCache::put(const string& key, const string& value) {
+    lock_guard<mutex> guard(lock);
+    if(entryCost(key, value) > budget) {
+        return;  // would evict everything else and still not fit
+    }
+    
+    auto it = index.find(key);
+    if(it != index.end()) {
+        used -= entryCost(key, it->second->value);
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    
+    Entry entry;
+    entry.key = key;
+    entry.value = value;
+    entries.push_front(entry);
+    index[key] = entries.begin();
+    used += entryCost(key, value);
+    evictToBudget();
+}
+
+// Remove one entry if present
+void QueryCache::invalidate(const string& key) {
+    lock_guard<mutex> guard(lock);
+    auto it = index.find(key);
+    if(it == index.end()) {
+        return;
+    }
+    used -= entryCost(key, it->second->value);
+    entries.erase(it->second);
+    index.erase(it);
+}
+
+void QueryCache::clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    index.clear();
+    used = 0;
+}
+
+void QueryCache::setBudget(size_t budgetBytes) {
+    lock_guard<mutex> guard(lock);
+    budget = budgetBytes;
+    evictToBudget();
+}
+
+long long QueryCache::getHits() const {
+    lock_guard<mutex> guard(lock);
+    return hits;
+}
+
+long long QueryCache::getMisses() const {
+    lock_guard<mutex> guard(lock);
+    return misses;
+}
+
+size_t QueryCache::getUsedBytes() const {
+    lock_guard<mutex> guard(lock);
+    return used;
+}
@@ -0,0 +1,46 @@
+#ifndef QUERY_CACHE_H
+#define QUERY_CACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+using namespace std;
+
+// Bounded LRU cache of rendered query results (text keyed by a string).
+// Size is counted in bytes of keys and values plus a fixed per-entry
+// overhead; the least recently used entries are evicted to stay within
+// the budget. Safe to use from several threads.
+class QueryCache {
+private:
+    struct Entry {
+        string key;
+        string value;
+    };
+
+    list<Entry> entries;  // most recently used first
+    unordered_map<string, list<Entry>::iterator> index;
+    size_t budget;
+    size_t used;
+    long long hits;
+    long long misses;
+    mutable mutex lock;
+
+    static size_t entryCost(const string& key, const string& value);
+    void evictToBudget();
+
+public:
+    QueryCache(size_t budgetBytes);
+
+    bool get(const string& key, string& value);
+    void put(const string& key, const string& value);
+    void invalidate(const string& key);
+    void clear();
+
+    void setBudget(size_t budgetBytes);  // 0 disables caching
+    long long getHits() const;
+    long long getMisses() const;
+    size_t getUsedBytes() const;
+};
+
+#endif
@@ -0,0 +1,356 @@
+#include "Shard.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+// How long a new shard may take to load its data and start listening
+static const int SHARD_START_TIMEOUT_MS = 30000;
+
+// Header line of displayAllStudents(); stripped from each shard's list
+static const string STUDENT_LIST_HEADER = "\n========== ALL STUDENTS ==========\n";
+static const string NO_STUDENTS = "\nNo students in the database!\n";
+
+// ---------- socket helpers ----------
+
+static bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while(sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if(n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// Receive until the buffer holds at least `count` bytes
+static bool fillBuffer(int fd, string& buffer, size_t count) {
+    char chunk[64 * 1024];
+    while(buffer.size() < count) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if(n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, n);
+    }
+    return true;
+}
+
+static bool receiveLine(int fd, string& buffer, string& line) {
+    size_t end;
+    while((end = buffer.find('\n')) == string::npos) {
+        if(!fillBuffer(fd, buffer, buffer.size() + 1)) {
+            return false;
+        }
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+static bool sendReply(int fd, const string& reply) {
+    return sendAll(fd, to_string(reply.size()) + "\n" + reply);
+}
+
+static bool receiveReply(int fd, string& buffer, string& reply) {
+    string header;
+    if(!receiveLine(fd, buffer, header)) {
+        return false;
+    }
+    size_t length = strtoul(header.c_str(), nullptr, 10);
+    if(!fillBuffer(fd, buffer, length)) {
+        return false;
+    }
+    reply = buffer.substr(0, length);
+    buffer.erase(0, length);
+    return true;
+}
+
+// ---------- shard server ----------
+
+// One connection: run each command line and send back its output.
+// The database lock keeps commands from different connections apart.
+static void serveConnection(int fd, LocalExecutor* executor, mutex* databaseLock) {
+    string buffer, line;
+    while(receiveLine(fd, buffer, line)) {
+        Command cmd;
+        string reply;
+        if(parseCommand(line, cmd)) {
+            lock_guard<mutex> guard(*databaseLock);
+            reply = executor->execute(cmd);
+        }
+        if(!sendReply(fd, reply)) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+int runShardServer(int port, string dataDir, bool compressed, int readyFd) {
+    mkdir(dataDir.c_str(), 0755);
+    if(chdir(dataDir.c_str()) != 0) {
+        cerr << "Shard: cannot enter " << dataDir << endl;
+        return 1;
+    }
+    
+    Database db;
+    if(compressed) {
+        db.setCompressedStorage(true);
+    }
+    LocalExecutor executor(db);
+    mutex databaseLock;
+    
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if(bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        cerr << "Shard: cannot listen on port " << port << endl;
+        close(listener);
+        return 1;
+    }
+    
+    if(readyFd >= 0) {
+        char ready = 1;
+        if(write(readyFd, &ready, 1) != 1) {
+            cerr << "Shard: cannot report readiness" << endl;
+        }
+        close(readyFd);
+    }
+    
+    while(true) {
+        int fd = accept(listener, nullptr, nullptr);
+        if(fd < 0) {
+            continue;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        thread(serveConnection, fd, &executor, &databaseLock).detach();
+    }
+}
+
+pid_t spawnShard(int port, string dataDir, bool compressed) {
+    int ready[2];
+    if(pipe(ready) != 0) {
+        return -1;
+    }
+    
+    pid_t router = getpid();
+    pid_t pid = fork();
+    if(pid == 0) {
+        // Go down with the router even if it is killed before stopShards()
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if(getppid() != router) {
+            _exit(1);
+        }
+        close(ready[0]);
+        _exit(runShardServer(port, dataDir, compressed, ready[1]));
+    }
+    close(ready[1]);
+    if(pid < 0) {
+        close(ready[0]);
+        return -1;
+    }
+    
+    // The byte arrives once the shard listens; end-of-file means it exited
+    // first (e.g. the port belongs to another process)
+    pollfd waiting = {ready[0], POLLIN, 0};
+    char byte;
+    bool listening = poll(&waiting, 1, SHARD_START_TIMEOUT_MS) == 1 && read(ready[0], &byte, 1) == 1;
+    close(ready[0]);
+    if(!listening) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+        return -1;
+    }
+    return pid;
+}
+
+void stopShards(const vector<pid_t>& pids) {
+    for(size_t i = 0; i < pids.size(); i++) {
+        if(pids[i] > 0) {
+            kill(pids[i], SIGTERM);
+        }
+    }
+    for(size_t i = 0; i < pids.size(); i++) {
+        if(pids[i] > 0) {
+            waitpid(pids[i], nullptr, 0);
+        }
+    }
+}
+
+// ---------- router ----------
+
+// Constructor
+ShardRouter::ShardRouter() {
+    rangePartition = false;
+    rangeFirst = 0;
+    rangeLast = 0;
+}
+
+// Destructor
+ShardRouter::~ShardRouter() {
+    for(size_t i = 0; i < shards.size(); i++) {
+        close(shards[i]->fd);
+        delete shards[i];
+    }
+}
+
+bool ShardRouter::connectShard(string host, int port) {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if(inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        return false;
+    }
+    
+    for(int attempt = 0; attempt < 100; attempt++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(connect(fd, (sockaddr*)&address, sizeof(address)) == 0) {
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            Shard* shard = new Shard();
+            shard->fd = fd;
+            shards.push_back(shard);
+            return true;
+        }
+        close(fd);
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    return false;
+}
+
+void ShardRouter::setRangePartition(long long first, long long last) {
+    rangePartition = true;
+    rangeFirst = first;
+    rangeLast = last;
+}
+
+int ShardRouter::getShardCount() const {
+    return shards.size();
+}
+
+// Which shard owns a roll number
+int ShardRouter::shardFor(int rollNo) const {
+    long long n = shards.size();
+    if(rangePartition) {
+        long long span = (rangeLast - rangeFirst) / n + 1;
+        long long index = ((long long)rollNo - rangeFirst) / span;
+        return index < 0 ? 0 : (index >= n ? n - 1 : index);
+    }
+    // Multiplicative hash so consecutive roll numbers spread evenly
+    unsigned int h = (unsigned int)rollNo * 2654435761u;
+    return h % n;
+}
+
+// Send one command line to a shard and wait for its output
+string ShardRouter::request(int index, const string& line) {
+    Shard* shard = shards[index];
+    lock_guard<mutex> guard(shard->lock);
+    string reply;
+    if(!sendAll(shard->fd, line + "\n") || !receiveReply(shard->fd, shard->buffer, reply)) {
+        return "Error: shard " + to_string(index) + " is not responding!\n";
+    }
+    return reply;
+}
+
+// Send a command to every shard. The catalogs are copies, so every shard
+// should answer like shard 0; any that does not is reported after it.
+string ShardRouter::broadcast(const string& line) {
+    string first = request(0, line);
+    string differences;
+    for(size_t i = 1; i < shards.size(); i++) {
+        string reply = request(i, line);
+        if(reply != first) {
+            differences += "Warning: shard " + to_string(i) + " answered differently:\n" + reply;
+        }
+    }
+    return first + differences;
+}
+
+string ShardRouter::execute(const Command& cmd) {
+    if(shards.empty()) {
+        return "Error: no shards connected!\n";
+    }
+    string line = formatCommand(cmd);
+    
+    switch(cmd.type) {
+        case CMD_INVALID:
+            return "Error: " + cmd.text + "\n";
+        
+        // The course catalog lives on every shard
+        case CMD_ADD_COURSE:
+        case CMD_DELETE_COURSE:
+            return broadcast(line);
+        case CMD_LIST_COURSES:
+            return request(0, line);
+        
+        case CMD_LIST_STUDENTS: {
+            string all;
+            for(size_t i = 0; i < shards.size(); i++) {
+                string part = request(i, line);
+                if(part.compare(0, STUDENT_LIST_HEADER.size(), STUDENT_LIST_HEADER) == 0) {
+                    all += part.substr(STUDENT_LIST_HEADER.size());
+                } else if(part != NO_STUDENTS) {
+                    all += part;  // error from an unreachable shard
+                }
+            }
+            return all.empty() ? NO_STUDENTS : STUDENT_LIST_HEADER + all;
+        }
+        
+        case CMD_COURSE_REPORT:
+        case CMD_COURSE_STATS: {
+            // Merge every shard's aggregates, then format once
+            Command statsCmd = cmd;
+            statsCmd.type = CMD_COURSE_STATS;
+            string statsLine = formatCommand(statsCmd);
+            
+            CourseStats total;
+            Course course;
+            for(size_t i = 0; i < shards.size(); i++) {
+                string answer = request(i, statsLine);
+                istringstream reply(answer);
+                string statsText, courseText;
+                getline(reply, statsText);
+                getline(reply, courseText);
+                if(statsText == "none") {
+                    return "Course not found!\n";
+                }
+                if(courseText.empty()) {
+                    return answer;  // error from an unreachable shard
+                }
+                CourseStats part;
+                part.deserialize(statsText);
+                total.merge(part);
+                course.deserialize(courseText);
+            }
+            if(cmd.type == CMD_COURSE_STATS) {
+                return total.serialize() + "\n" + course.serialize() + "\n";
+            }
+            return Database::formatCourseReport(course, total);
+        }
+        
+        // Everything else belongs to one student
+        default:
+            return request(shardFor(cmd.rollNo), line);
+    }
+}
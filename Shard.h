@@ -0,0 +1,65 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <sys/types.h>
+#include "CommandPipeline.h"
+using namespace std;
+
+// Sharded deployment: students are split by roll number over several
+// shard processes, each running its own Database in its own directory.
+//
+// Shards speak the script syntax over TCP: the router sends one command
+// line, the shard answers with "<length>\n" followed by the output.
+// The course catalog is copied to every shard so enrollments can be
+// checked locally.
+
+// Serve commands on 127.0.0.1:port with data files in dataDir. Never returns
+// unless the socket cannot be set up. Once listening, one byte is written
+// to readyFd (if given) and it is closed.
+int runShardServer(int port, string dataDir, bool compressed, int readyFd = -1);
+
+// Fork a shard server process and wait until it is listening; returns its
+// pid, or -1 if it exited or did not get ready in time. The shard gets
+// SIGTERM when the calling process dies.
+pid_t spawnShard(int port, string dataDir, bool compressed);
+
+// Terminate and reap spawned shard processes
+void stopShards(const vector<pid_t>& pids);
+
+// Forwards each command to the shard that owns the student, and
+// scatter-gathers lists and course reports over all shards.
+class ShardRouter : public CommandExecutor {
+private:
+    struct Shard {
+        int fd;
+        string buffer;  // bytes received but not consumed yet
+        mutex lock;     // one request at a time per connection
+    };
+
+    vector<Shard*> shards;
+    bool rangePartition;
+    long long rangeFirst;
+    long long rangeLast;
+
+    string request(int shard, const string& line);
+    string broadcast(const string& line);
+    int shardFor(int rollNo) const;
+
+public:
+    ShardRouter();
+    ~ShardRouter();
+
+    // Connect to a shard, retrying for a few seconds while it starts up
+    bool connectShard(string host, int port);
+
+    // Split [first, last] into equal roll ranges instead of hashing
+    void setRangePartition(long long first, long long last);
+
+    int getShardCount() const;
+    string execute(const Command& cmd);
+};
+
+#endif
@@ -0,0 +1,359 @@
+#include "Snapshot.h"
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <cstdio>
+
+// File starts with this tag so a text file is never mistaken for a snapshot
+static const char MAGIC[4] = {'S', 'M', 'S', '1'};
+
+// Records are flushed into a new block once the raw data reaches this size
+static const size_t BLOCK_SIZE = 64 * 1024;
+
+// Largest raw block written or accepted: the record that crosses BLOCK_SIZE
+// must fit in the slack. Sizes read from the file are checked against it
+// before anything is allocated.
+static const size_t MAX_BLOCK_SIZE = BLOCK_SIZE + 64 * 1024;
+
+// LZ matches shorter than this are stored as literals
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 14;
+
+// ---------- varint helpers ----------
+
+static void putVarint(string& out, unsigned long long value) {
+    while(value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+static bool getVarint(const string& in, size_t& pos, unsigned long long& value) {
+    value = 0;
+    int shift = 0;
+    while(pos < in.size() && shift < 64) {
+        unsigned char byte = in[pos++];
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            return true;
+        }
+        shift += 7;
+    }
+    return false;  // truncated or overlong
+}
+
+// Zigzag keeps small negative numbers small (-1 -> 1, 1 -> 2)
+static unsigned long long zigzag(long long value) {
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+static long long unzigzag(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+static bool readVarintFromFile(ifstream& file, unsigned long long& value) {
+    value = 0;
+    int shift = 0;
+    char c;
+    while(shift < 64 && file.get(c)) {
+        unsigned char byte = c;
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+
+// ---------- LZ block compression ----------
+
+static unsigned int read32(const char* p) {
+    unsigned int v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static unsigned int hash32(unsigned int v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Each sequence is: literal count, literals, match offset, match length - MIN_MATCH.
+// The last sequence stops after its literals.
+static string compressBlock(const string& raw) {
+    string out;
+    out.reserve(raw.size() / 2);
+    vector<int> table(1 << HASH_BITS, -1);
+
+    const char* data = raw.data();
+    size_t n = raw.size();
+    size_t anchor = 0;
+    size_t i = 0;
+
+    while(i + MIN_MATCH <= n) {
+        unsigned int h = hash32(read32(data + i));
+        int candidate = table[h];
+        table[h] = (int)i;
+
+        if(candidate >= 0 && i - candidate <= MAX_OFFSET &&
+           read32(data + candidate) == read32(data + i)) {
+            size_t length = MIN_MATCH;
+            while(i + length < n && data[candidate + length] == data[i + length]) {
+                length++;
+            }
+
+            putVarint(out, i - anchor);
+            out.append(data + anchor, i - anchor);
+            putVarint(out, i - candidate);
+            putVarint(out, length - MIN_MATCH);
+
+            i += length;
+            anchor = i;
+        } else {
+            i++;
+        }
+    }
+
+    putVarint(out, n - anchor);
+    out.append(data + anchor, n - anchor);
+    return out;
+}
+
+static bool decompressBlock(const string& packed, size_t rawSize, string& raw) {
+    raw.clear();
+    raw.reserve(rawSize);
+    size_t pos = 0;
+
+    while(pos < packed.size()) {
+        unsigned long long literals;
+        if(!getVarint(packed, pos, literals) || literals > packed.size() - pos) {
+            return false;
+        }
+        raw.append(packed, pos, literals);
+        pos += literals;
+
+        if(pos == packed.size()) {
+            break;  // final sequence has no match
+        }
+
+        unsigned long long offset, length;
+        if(!getVarint(packed, pos, offset) || !getVarint(packed, pos, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if(offset == 0 || offset > raw.size() || raw.size() + length > rawSize) {
+            return false;
+        }
+
+        // Byte by byte: a match may overlap the bytes it is producing
+        size_t from = raw.size() - offset;
+        for(size_t k = 0; k < length; k++) {
+            raw += raw[from + k];
+        }
+    }
+
+    return raw.size() == rawSize;
+}
+
+// ---------- record encoding ----------
+
+// Course codes are shared across the whole file; a new code is written as
+// the next free id followed by its text, later uses write only the id.
+static void putCourse(string& out, const string& code, map<string, unsigned long long>& ids) {
+    auto it = ids.find(code);
+    if(it != ids.end()) {
+        putVarint(out, it->second);
+        return;
+    }
+    unsigned long long id = ids.size();
+    ids[code] = id;
+    putVarint(out, id);
+    putVarint(out, code.size());
+    out += code;
+}
+
+static bool getString(const string& in, size_t& pos, string& text) {
+    unsigned long long length;
+    if(!getVarint(in, pos, length) || length > in.size() - pos) {
+        return false;
+    }
+    text.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+static bool getCourse(const string& in, size_t& pos, vector<string>& dictionary, string& code) {
+    unsigned long long id;
+    if(!getVarint(in, pos, id)) {
+        return false;
+    }
+    if(id == dictionary.size()) {
+        if(!getString(in, pos, code)) {
+            return false;
+        }
+        dictionary.push_back(code);
+        return true;
+    }
+    if(id > dictionary.size()) {
+        return false;
+    }
+    code = dictionary[id];
+    return true;
+}
+
+static void writeBlock(ofstream& file, const string& raw) {
+    string packed = compressBlock(raw);
+    string header;
+    putVarint(header, raw.size());
+    putVarint(header, packed.size());
+    file.write(header.data(), header.size());
+    file.write(packed.data(), packed.size());
+}
+
+// Save all students to a compressed snapshot file. The data goes to a
+// temporary file first and replaces the old snapshot only when complete,
+// so a crash during the save leaves the previous snapshot intact.
+bool Snapshot::save(const vector<Student>& students, string filename) {
+    string tempName = filename + ".tmp";
+    ofstream file(tempName.c_str(), ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    file.write(MAGIC, sizeof(MAGIC));
+
+    map<string, unsigned long long> courseIds;
+    long long previousRoll = 0;
+    string block;
+    block.reserve(BLOCK_SIZE + 1024);
+
+    for(size_t i = 0; i < students.size(); i++) {
+        const Student& s = students[i];
+        size_t recordStart = block.size();
+
+        putVarint(block, zigzag((long long)s.getRollNo() - previousRoll));
+        previousRoll = s.getRollNo();
+
+        string name = s.getName();
+        putVarint(block, name.size());
+        block += name;
+        putVarint(block, zigzag(s.getAge()));
+
+        const vector<string>& courses = s.getCourses();
+        putVarint(block, courses.size());
+        for(size_t c = 0; c < courses.size(); c++) {
+            putCourse(block, courses[c], courseIds);
+        }
+
+        const map<string, float>& grades = s.getGrades();
+        putVarint(block, grades.size());
+        for(auto it = grades.begin(); it != grades.end(); it++) {
+            putCourse(block, it->first, courseIds);
+            putVarint(block, zigzag(llround(it->second * 100.0)));
+        }
+
+        // A record that would overflow the block starts the next one
+        if(block.size() > MAX_BLOCK_SIZE) {
+            if(recordStart == 0) {
+                file.close();
+                remove(tempName.c_str());
+                return false;  // one student larger than a block
+            }
+            writeBlock(file, block.substr(0, recordStart));
+            block.erase(0, recordStart);
+        }
+
+        if(block.size() >= BLOCK_SIZE) {
+            writeBlock(file, block);
+            block.clear();
+        }
+    }
+
+    if(!block.empty()) {
+        writeBlock(file, block);
+    }
+
+    file.close();
+    if(file.fail() || rename(tempName.c_str(), filename.c_str()) != 0) {
+        remove(tempName.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Load students from a compressed snapshot, one block at a time
+bool Snapshot::load(string filename, vector<Student>& students) {
+    ifstream file(filename.c_str(), ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+
+    file.seekg(0, ios::end);
+    unsigned long long fileSize = file.tellg();
+    file.seekg(0, ios::beg);
+
+    char magic[sizeof(MAGIC)];
+    if(!file.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    vector<string> dictionary;
+    long long previousRoll = 0;
+    string packed, raw;
+
+    while(file.peek() != EOF) {
+        unsigned long long rawSize, packedSize;
+        if(!readVarintFromFile(file, rawSize) || !readVarintFromFile(file, packedSize)) {
+            return false;
+        }
+        if(rawSize > MAX_BLOCK_SIZE || packedSize > fileSize - (unsigned long long)file.tellg()) {
+            return false;  // damaged sizes; never allocate from them
+        }
+        packed.resize(packedSize);
+        if(!file.read(&packed[0], packedSize) || !decompressBlock(packed, rawSize, raw)) {
+            return false;
+        }
+
+        size_t pos = 0;
+        while(pos < raw.size()) {
+            unsigned long long value, count;
+            string name;
+
+            if(!getVarint(raw, pos, value)) return false;
+            long long roll = previousRoll + unzigzag(value);
+            previousRoll = roll;
+
+            if(!getString(raw, pos, name)) return false;
+            if(!getVarint(raw, pos, value)) return false;
+            int age = (int)unzigzag(value);
+
+            Student s(roll, name, age);
+
+            if(!getVarint(raw, pos, count)) return false;
+            vector<string> courses;
+            courses.reserve(count < 64 ? count : 64);
+            for(unsigned long long c = 0; c < count; c++) {
+                string code;
+                if(!getCourse(raw, pos, dictionary, code)) return false;
+                courses.push_back(code);
+            }
+            s.setCourses(courses);
+
+            if(!getVarint(raw, pos, count)) return false;
+            map<string, float> grades;
+            for(unsigned long long g = 0; g < count; g++) {
+                string code;
+                if(!getCourse(raw, pos, dictionary, code)) return false;
+                if(!getVarint(raw, pos, value)) return false;
+                grades[code] = unzigzag(value) / 100.0f;
+            }
+            s.setGrades(grades);
+
+            students.push_back(s);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include "Student.h"
+using namespace std;
+
+// Compressed on-disk format for the student list (students.dat).
+//
+// Records are packed into ~64 KB blocks and each block is LZ-compressed
+// on its own, so loading can decode one block at a time. Inside a block:
+//   - roll numbers are stored as varint deltas from the previous record
+//   - course codes are dictionary encoded (first use spells the code out)
+//   - grades are quantized to hundredths, the precision shown on screen
+class Snapshot {
+public:
+    // Returns false if the file cannot be written, or if one student's
+    // record is too large for a block (over 128 KB)
+    static bool save(const vector<Student>& students, string filename);
+
+    // Returns false if the file is missing or damaged; students from the
+    // blocks before the damage are still appended to `students`.
+    static bool load(string filename, vector<Student>& students);
+};
+
+#endif
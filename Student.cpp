@@ -1,7 +1,7 @@
 #include "Student.h"
 #include <iostream>
 #include <iomanip>
-#include <sstream>
+#include <charconv>
 
 // Default constructor
 Student::Student() {
@@ -30,10 +30,14 @@ int Student::getAge() const {
     return age;
 }
 
-vector<string> Student::getCourses() const {
+const vector<string>& Student::getCourses() const {
     return courses;
 }
 
+const map<string, float>& Student::getGrades() const {
+    return grades;
+}
+
 // Setter methods
 void Student::setName(string newName) {
     name = newName;
@@ -43,29 +47,41 @@ void Student::setAge(int newAge) {
     age = newAge;
 }
 
+// Replace the course list as-is (used when loading stored records)
+void Student::setCourses(vector<string> courseCodes) {
+    courses = courseCodes;
+}
+
+// Replace all grades as-is (used when loading stored records)
+void Student::setGrades(map<string, float> courseGrades) {
+    grades = courseGrades;
+}
+
 // Add a course to student's course list
-void Student::addCourse(string courseCode) {
+bool Student::addCourse(string courseCode, ostream& out) {
     // Check if course already exists
     for(int i = 0; i < courses.size(); i++) {
         if(courses[i] == courseCode) {
-            cout << "Course already enrolled!" << endl;
-            return;
+            out << "Course already enrolled!" << endl;
+            return false;
         }
     }
     courses.push_back(courseCode);
-    cout << "Course " << courseCode << " added successfully!" << endl;
+    out << "Course " << courseCode << " added successfully!" << endl;
+    return true;
 }
 
 // Add grade for a specific course
-void Student::addGrade(string courseCode, float grade) {
+bool Student::addGrade(string courseCode, float grade, ostream& out) {
     // Validate grade (0-10 scale or 0-4 GPA scale)
     if(grade < 0 || grade > 10) {
-        cout << "Invalid grade! Please enter between 0-10" << endl;
-        return;
+        out << "Invalid grade! Please enter between 0-10" << endl;
+        return false;
     }
     
     grades[courseCode] = grade;
-    cout << "Grade added successfully!" << endl;
+    out << "Grade added successfully!" << endl;
+    return true;
 }
 
 // Calculate GPA based on all course grades
@@ -87,96 +103,102 @@ float Student::calculateGPA() const {
 }
 
 // Display student information
-void Student::displayInfo() const {
-    cout << "\n========================================" << endl;
-    cout << "Roll No: " << rollNo << endl;
-    cout << "Name: " << name << endl;
-    cout << "Age: " << age << endl;
+void Student::displayInfo(ostream& out) const {
+    out << "\n========================================" << endl;
+    out << "Roll No: " << rollNo << endl;
+    out << "Name: " << name << endl;
+    out << "Age: " << age << endl;
     
-    cout << "\nEnrolled Courses: ";
+    out << "\nEnrolled Courses: ";
     if(courses.empty()) {
-        cout << "No courses enrolled" << endl;
+        out << "No courses enrolled" << endl;
     } else {
-        cout << endl;
+        out << endl;
         for(int i = 0; i < courses.size(); i++) {
-            cout << "  - " << courses[i];
+            out << "  - " << courses[i];
             
             // Display grade if available
             auto it = grades.find(courses[i]);
             if(it != grades.end()) {
-                cout << " (Grade: " << fixed << setprecision(2) << it->second << ")";
+                out << " (Grade: " << fixed << setprecision(2) << it->second << ")";
             }
-            cout << endl;
+            out << endl;
         }
     }
     
     // Display GPA
     float gpa = calculateGPA();
     if(gpa > 0) {
-        cout << "\nGPA: " << fixed << setprecision(2) << gpa << endl;
+        out << "\nGPA: " << fixed << setprecision(2) << gpa << endl;
     }
-    cout << "========================================\n" << endl;
+    out << "========================================\n" << endl;
 }
 
 // Convert student data to string for file storage
 string Student::serialize() const {
-    stringstream ss;
-    ss << rollNo << "|" << name << "|" << age << "|";
+    string line;
+    line.reserve(64 + name.size() + 12 * (courses.size() + grades.size()));
+    line += to_string(rollNo);
+    line += '|';
+    line += name;
+    line += '|';
+    line += to_string(age);
+    line += '|';
     
     // Add courses
-    for(int i = 0; i < courses.size(); i++) {
-        ss << courses[i];
-        if(i < courses.size() - 1) ss << ",";
+    for(size_t i = 0; i < courses.size(); i++) {
+        if(i > 0) line += ',';
+        line += courses[i];
     }
-    ss << "|";
+    line += '|';
     
-    // Add grades
-    int count = 0;
+    // Add grades, printed like a stream would (6 significant digits)
+    char number[32];
     for(auto it = grades.begin(); it != grades.end(); it++) {
-        ss << it->first << ":" << it->second;
-        if(count < grades.size() - 1) ss << ",";
-        count++;
+        if(it != grades.begin()) line += ',';
+        line += it->first;
+        line += ':';
+        char* end = to_chars(number, number + sizeof(number), it->second, chars_format::general, 6).ptr;
+        line.append(number, end - number);
     }
     
-    return ss.str();
+    return line;
+}
+
+// Next field up to the separator; the view is moved past the separator
+static string_view nextField(string_view& data, char separator) {
+    size_t end = data.find(separator);
+    string_view field = data.substr(0, end);
+    data.remove_prefix(end == string_view::npos ? data.size() : end + 1);
+    return field;
+}
+
+static int toInt(string_view text) {
+    int value = 0;
+    from_chars(text.data(), text.data() + text.size(), value);
+    return value;
 }
 
 // Load student data from string
-void Student::deserialize(string data) {
-    stringstream ss(data);
-    string token;
-    
-    // Read roll number
-    getline(ss, token, '|');
-    rollNo = stoi(token);
-    
-    // Read name
-    getline(ss, name, '|');
-    
-    // Read age
-    getline(ss, token, '|');
-    age = stoi(token);
+void Student::deserialize(string_view data) {
+    // Read roll number, name and age
+    rollNo = toInt(nextField(data, '|'));
+    name = string(nextField(data, '|'));
+    age = toInt(nextField(data, '|'));
     
     // Read courses
-    getline(ss, token, '|');
-    if(!token.empty()) {
-        stringstream courseStream(token);
-        string course;
-        while(getline(courseStream, course, ',')) {
-            courses.push_back(course);
-        }
+    string_view courseList = nextField(data, '|');
+    while(!courseList.empty()) {
+        courses.push_back(string(nextField(courseList, ',')));
     }
     
     // Read grades
-    getline(ss, token, '|');
-    if(!token.empty()) {
-        stringstream gradeStream(token);
-        string gradeData;
-        while(getline(gradeStream, gradeData, ',')) {
-            int colonPos = gradeData.find(':');
-            string courseCode = gradeData.substr(0, colonPos);
-            float grade = stof(gradeData.substr(colonPos + 1));
-            grades[courseCode] = grade;
-        }
+    string_view gradeList = nextField(data, '|');
+    while(!gradeList.empty()) {
+        string_view gradeData = nextField(gradeList, ',');
+        string_view courseCode = nextField(gradeData, ':');
+        float grade = 0;
+        from_chars(gradeData.data(), gradeData.data() + gradeData.size(), grade);
+        grades[string(courseCode)] = grade;
     }
 }
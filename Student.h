@@ -2,8 +2,10 @@
 #define STUDENT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <iostream>
 using namespace std;
 
 class Student {
@@ -23,21 +25,24 @@ public:
     int getRollNo() const;
     string getName() const;
     int getAge() const;
-    vector<string> getCourses() const;
+    const vector<string>& getCourses() const;
+    const map<string, float>& getGrades() const;
     
     // Setters
     void setName(string newName);
     void setAge(int newAge);
+    void setCourses(vector<string> courseCodes);  // no duplicate check, no output
+    void setGrades(map<string, float> courseGrades);  // no validation, no output
     
     // Core functions
-    void addCourse(string courseCode);
-    void addGrade(string courseCode, float grade);
+    bool addCourse(string courseCode, ostream& out = cout);  // false if already enrolled
+    bool addGrade(string courseCode, float grade, ostream& out = cout);  // false if out of range
     float calculateGPA() const;
-    void displayInfo() const;
+    void displayInfo(ostream& out = cout) const;
     
     // For file operations
     string serialize() const;  // convert to string for saving
-    void deserialize(string data);  // load from string
+    void deserialize(string_view data);  // load from string
 };
 
 #endif
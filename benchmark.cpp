@@ -0,0 +1,533 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Database.h"
+#include "CommandPipeline.h"
+#include "Shard.h"
+#include "ChangeFeed.h"
+#include <atomic>
+
+using namespace std;
+
+// Benchmarks run inside this directory so real data files are never touched
+static const char* BENCH_DIR = "bench_data";
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static long long fileSize(const char* filename) {
+    struct stat info;
+    if(stat(filename, &info) != 0) {
+        return 0;
+    }
+    return info.st_size;
+}
+
+// Write a synthetic students.txt and courses.txt with the given number of students.
+// Every student takes 3-6 of 40 courses and has grades for most of them.
+static void generateDataset(int count) {
+    mt19937 rng(42);
+    vector<string> codes;
+    const char* departments[] = {"CS", "MATH", "PHY", "CHEM", "ENG"};
+    for(int d = 0; d < 5; d++) {
+        for(int n = 1; n <= 8; n++) {
+            codes.push_back(string(departments[d]) + to_string(100 * (n % 4 + 1) + n));
+        }
+    }
+    const char* firstNames[] = {"John", "Priya", "Wei", "Maria", "Ahmed", "Olga", "Kenji", "Sara"};
+    const char* lastNames[] = {"Doe", "Sharma", "Chen", "Garcia", "Khan", "Ivanova", "Sato", "Smith"};
+
+    ofstream courseFile("courses.txt");
+    for(size_t i = 0; i < codes.size(); i++) {
+        courseFile << codes[i] << "|Course " << codes[i] << "|" << (3 + i % 2) << '\n';
+    }
+    courseFile.close();
+
+    ofstream studentFile("students.txt");
+    for(int i = 0; i < count; i++) {
+        int rollNo = 1000 + i;
+        string name = string(firstNames[rng() % 8]) + " " + lastNames[rng() % 8];
+        int age = 18 + rng() % 8;
+
+        int taken = 3 + rng() % 4;
+        vector<string> courses;
+        while((int)courses.size() < taken) {
+            string code = codes[rng() % codes.size()];
+            bool seen = false;
+            for(size_t c = 0; c < courses.size(); c++) {
+                if(courses[c] == code) seen = true;
+            }
+            if(!seen) courses.push_back(code);
+        }
+
+        Student s(rollNo, name, age);
+        s.setCourses(courses);
+        map<string, float> grades;
+        for(size_t c = 0; c < courses.size(); c++) {
+            if(rng() % 5 != 0) {
+                grades[courses[c]] = (rng() % 41) / 4.0f;  // 0.00 .. 10.00 in steps of 0.25
+            }
+        }
+        s.setGrades(grades);
+        studentFile << s.serialize() << '\n';
+    }
+    studentFile.close();
+}
+
+// Compare text and compressed snapshot size, save time and load time
+static void benchStorage(int count) {
+    remove("students.dat");
+    generateDataset(count);
+    cout << "Storage benchmark: " << count << " students" << endl;
+
+    auto start = chrono::steady_clock::now();
+    Database* textDb = new Database();
+    double textLoad = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    textDb->saveToFile();
+    double textSave = secondsSince(start);
+    long long textBytes = fileSize("students.txt");
+
+    textDb->setCompressedStorage(true);
+    start = chrono::steady_clock::now();
+    textDb->saveToFile();
+    double packedSave = secondsSince(start);
+    long long packedBytes = fileSize("students.dat");
+    delete textDb;
+
+    start = chrono::steady_clock::now();
+    Database* packedDb = new Database();
+    double packedLoad = secondsSince(start);
+    delete packedDb;
+
+    cout << fixed << setprecision(3);
+    cout << "  format       size (bytes)   save (s)   load (s)" << endl;
+    cout << "  text     " << setw(15) << textBytes << setw(11) << textSave << setw(11) << textLoad << endl;
+    cout << "  compressed" << setw(14) << packedBytes << setw(11) << packedSave << setw(11) << packedLoad << endl;
+    cout << setprecision(2);
+    cout << "  compression ratio: " << (double)textBytes / packedBytes << "x" << endl;
+}
+
+// Scripted throughput of the command pipeline with 1 worker and with several.
+// The script is mostly lookups with an occasional grade update.
+static void benchPipeline(int count) {
+    remove("students.dat");
+    generateDataset(count);
+    
+    mt19937 rng(7);
+    int commands = 50000;
+    ofstream script("script.txt");
+    for(int i = 0; i < commands; i++) {
+        int rollNo = 1000 + rng() % count;
+        if(i % 2000 == 1999) {
+            script << "grade " << rollNo << " CS101 " << (rng() % 11) << '\n';
+        } else {
+            script << "search " << rollNo << '\n';
+        }
+    }
+    script.close();
+    
+    cout << "Pipeline benchmark: " << commands << " commands, " << count << " students" << endl;
+    int threads = thread::hardware_concurrency();
+    int workerCounts[] = {1, 2, 4, threads};
+    for(int w = 0; w < 4; w++) {
+        if(w > 0 && workerCounts[w] <= workerCounts[w - 1]) continue;
+        
+        Database db;
+        ofstream discard("/dev/null");
+        LocalExecutor executor(db);
+        CommandPipeline pipeline(executor, workerCounts[w], discard);
+        pipeline.addSource("script.txt");
+        
+        auto start = chrono::steady_clock::now();
+        long long done = pipeline.run();
+        double seconds = secondsSince(start);
+        cout << "  " << setw(2) << workerCounts[w] << " workers: " << fixed << setprecision(0)
+             << done / seconds << " commands/sec" << endl;
+    }
+}
+
+// Draws ranks 0..n-1 where rank k is picked with probability ~ 1/(k+1)^s
+class ZipfGenerator {
+private:
+    vector<double> cdf;
+    uniform_real_distribution<double> uniform;
+
+public:
+    ZipfGenerator(int n, double s) : uniform(0.0, 1.0) {
+        cdf.resize(n);
+        double total = 0;
+        for(int k = 0; k < n; k++) {
+            total += 1.0 / pow(k + 1, s);
+            cdf[k] = total;
+        }
+        for(int k = 0; k < n; k++) {
+            cdf[k] /= total;
+        }
+    }
+
+    int next(mt19937& rng) {
+        double u = uniform(rng);
+        return lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    }
+};
+
+// Front-desk workload: Zipf-skewed student lookups with an occasional
+// course report, run with the cache off and with a few budgets
+static void benchCache(int count) {
+    remove("students.dat");
+    generateDataset(count);
+    
+    // Popular students are spread over the roll range, not the first rows
+    vector<int> rolls(count);
+    for(int i = 0; i < count; i++) rolls[i] = 1000 + i;
+    mt19937 shuffleRng(3);
+    shuffle(rolls.begin(), rolls.end(), shuffleRng);
+    
+    int lookups = 200000;
+    ZipfGenerator zipf(count, 0.99);
+    cout << "Cache benchmark: " << lookups << " Zipf(0.99) lookups, " << count << " students" << endl;
+    
+    size_t budgets[] = {0, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+    for(int b = 0; b < 4; b++) {
+        Database db;
+        db.setCacheBudget(budgets[b]);
+        mt19937 rng(11);
+        size_t bytes = 0;
+        
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < lookups; i++) {
+            if(i % 100 == 99) {
+                bytes += db.renderCourseReport("CS101").size();
+            } else {
+                bytes += db.renderStudent(rolls[zipf.next(rng)]).size();
+            }
+        }
+        double seconds = secondsSince(start);
+        
+        cout << "  budget " << setw(7) << budgets[b] / 1024 << " KB: " << fixed << setprecision(0)
+             << setw(8) << lookups / seconds << " lookups/sec   ";
+        db.displayCacheStats(cout);
+    }
+}
+
+// Write throughput of 1, 2, 4 and 8 local shards. Eight client threads
+// add, enroll and grade students through one router.
+static void benchShards(int count) {
+    const int clients = 8;
+    cout << "Shard benchmark: " << 3 * count << " writes (" << count << " students), "
+         << clients << " client threads" << endl;
+    
+    int shardCounts[] = {1, 2, 4, 8};
+    for(int s = 0; s < 4; s++) {
+        int n = shardCounts[s];
+        string dir = "shards_" + to_string(n);
+        system(("rm -rf " + dir).c_str());
+        mkdir(dir.c_str(), 0755);
+        
+        vector<pid_t> pids;
+        int basePort = 7700 + 10 * n;
+        bool started = true;
+        for(int i = 0; i < n && started; i++) {
+            pids.push_back(spawnShard(basePort + i, dir + "/shard_" + to_string(i), false));
+            started = pids.back() > 0;
+        }
+        
+        {
+            ShardRouter router;
+            bool connected = started;
+            for(int i = 0; i < n; i++) {
+                connected = connected && router.connectShard("127.0.0.1", basePort + i);
+            }
+            if(!connected) {
+                cout << "  could not start " << n << " shards" << endl;
+                stopShards(pids);
+                continue;
+            }
+            
+            Command setup;
+            parseCommand("addcourse CS101 4 Data Structures", setup);
+            router.execute(setup);
+            
+            auto start = chrono::steady_clock::now();
+            vector<thread> threads;
+            for(int t = 0; t < clients; t++) {
+                threads.push_back(thread([&router, count, t, clients]() {
+                    for(int i = t; i < count; i += clients) {
+                        int rollNo = 1000 + i;
+                        string lines[] = {
+                            "add " + to_string(rollNo) + " 20 Student " + to_string(i),
+                            "enroll " + to_string(rollNo) + " CS101",
+                            "grade " + to_string(rollNo) + " CS101 " + to_string(i % 11)
+                        };
+                        for(int k = 0; k < 3; k++) {
+                            Command cmd;
+                            parseCommand(lines[k], cmd);
+                            router.execute(cmd);
+                        }
+                    }
+                }));
+            }
+            for(size_t t = 0; t < threads.size(); t++) {
+                threads[t].join();
+            }
+            double seconds = secondsSince(start);
+            
+            cout << "  " << n << " shard" << (n > 1 ? "s" : " ") << ": " << fixed << setprecision(0)
+                 << setw(8) << 3 * count / seconds << " writes/sec" << endl;
+        }
+        stopShards(pids);
+    }
+}
+
+// Records of the generated students.txt, which is then removed so a
+// new Database starts empty (with the generated courses)
+static vector<Student> takeGeneratedStudents() {
+    vector<Student> records;
+    ifstream file("students.txt");
+    string line;
+    while(getline(file, line)) {
+        Student s;
+        s.deserialize(line);
+        records.push_back(s);
+    }
+    file.close();
+    remove("students.txt");
+    return records;
+}
+
+// Time bulkAddStudents() on a fresh database, including the final save
+static double timeBulkLoad(vector<Student> records) {
+    remove("students.txt");
+    Database db;
+    auto start = chrono::steady_clock::now();
+    db.bulkAddStudents(records);
+    return secondsSince(start);
+}
+
+// One-by-one inserts (add, enroll, grade) against the bulk path
+static void benchBulk(int count) {
+    remove("students.dat");
+    generateDataset(count);
+    vector<Student> records = takeGeneratedStudents();
+    int slowCount = count < 1000 ? count : 1000;
+    cout << "Bulk load benchmark: " << count << " students" << endl;
+    
+    // The per-record path prints and saves after every call
+    {
+        Database db;
+        ofstream discard("/dev/null");
+        streambuf* console = cout.rdbuf(discard.rdbuf());
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < slowCount; i++) {
+            const Student& s = records[i];
+            db.addStudent(s.getRollNo(), s.getName(), s.getAge());
+            const vector<string>& taken = s.getCourses();
+            for(size_t c = 0; c < taken.size(); c++) {
+                db.enrollStudentInCourse(s.getRollNo(), taken[c]);
+            }
+            const map<string, float>& grades = s.getGrades();
+            for(auto it = grades.begin(); it != grades.end(); it++) {
+                db.addGradeToStudent(s.getRollNo(), it->first, it->second);
+            }
+        }
+        double seconds = secondsSince(start);
+        cout.rdbuf(console);
+        cout << fixed << setprecision(3);
+        cout << "  one by one, " << setw(7) << slowCount << " students: " << setw(9) << seconds << " s" << endl;
+    }
+    
+    vector<Student> first(records.begin(), records.begin() + slowCount);
+    cout << "  bulk,       " << setw(7) << slowCount << " students: " << setw(9) << timeBulkLoad(first) << " s" << endl;
+    cout << "  bulk sorted," << setw(7) << count << " students: " << setw(9) << timeBulkLoad(records) << " s" << endl;
+    
+    mt19937 rng(5);
+    shuffle(records.begin(), records.end(), rng);
+    cout << "  bulk random," << setw(7) << count << " students: " << setw(9) << timeBulkLoad(records) << " s" << endl;
+}
+
+static void reportOperation(const char* name, long long count, double seconds) {
+    cout << "  " << left << setw(8) << name << right << setw(9) << count << " ops "
+         << fixed << setprecision(3) << setw(9) << seconds << " s "
+         << setprecision(0) << setw(12) << count / seconds << " ops/sec" << endl;
+}
+
+// Hot paths of Database: load, search, enroll, grade and save. Also the
+// training workload for the PGO build.
+static void benchCore(int count) {
+    remove("students.dat");
+    generateDataset(count);
+    cout << "Core benchmark: " << count << " students" << endl;
+    
+    auto start = chrono::steady_clock::now();
+    Database db;
+    reportOperation("load", count, secondsSince(start));
+    db.setAutoSave(false);  // time the operations, not a save after each
+    
+    mt19937 rng(9);
+    int searches = 1000000;
+    long long found = 0;
+    start = chrono::steady_clock::now();
+    for(int i = 0; i < searches; i++) {
+        found += db.searchStudent(1000 + rng() % (count + count / 10)) != nullptr;
+    }
+    reportOperation("search", searches, secondsSince(start));
+    
+    const char* codes[] = {"CS101", "CS205", "MATH108", "PHY104", "ENG302", "CHEM403"};
+    int updates = 200000;
+    ofstream discard("/dev/null");
+    streambuf* console = cout.rdbuf(discard.rdbuf());
+    
+    start = chrono::steady_clock::now();
+    for(int i = 0; i < updates; i++) {
+        db.enrollStudentInCourse(1000 + rng() % count, codes[rng() % 6]);
+    }
+    double enrollSeconds = secondsSince(start);
+    
+    start = chrono::steady_clock::now();
+    for(int i = 0; i < updates; i++) {
+        db.addGradeToStudent(1000 + rng() % count, codes[rng() % 6], (rng() % 41) / 4.0f);
+    }
+    double gradeSeconds = secondsSince(start);
+    
+    cout.rdbuf(console);
+    reportOperation("enroll", updates, enrollSeconds);
+    reportOperation("grade", updates, gradeSeconds);
+    
+    start = chrono::steady_clock::now();
+    db.saveToFile();
+    reportOperation("save", count, secondsSince(start));
+    
+    if(found == 0) {
+        cout << "  (no search hits)" << endl;  // keeps the lookups from being optimized away
+    }
+}
+
+// Time `count` grade updates with the change feed on or off
+static double timeGrades(Database& db, int students, int count, bool feedOn) {
+    db.getChangeFeed().setEnabled(feedOn);
+    mt19937 rng(13);
+    ofstream discard("/dev/null");
+    streambuf* console = cout.rdbuf(discard.rdbuf());
+    auto start = chrono::steady_clock::now();
+    for(int i = 0; i < count; i++) {
+        db.addGradeToStudent(1000 + rng() % students, "CS101", (rng() % 41) / 4.0f);
+    }
+    double seconds = secondsSince(start);
+    cout.rdbuf(console);
+    return seconds;
+}
+
+// Cost of publishing to the change feed: bare publish() with and without
+// a reader tailing the ring, and a Database mutation with the feed on/off
+static void benchChangeFeed(int count) {
+    int publishes = 10000000;
+    cout << "Change feed benchmark" << endl;
+    cout << fixed << setprecision(1);
+    
+    {
+        ChangeFeed feed;
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < publishes; i++) {
+            feed.publish(CHANGE_GRADE, 1000 + i, 7.5f, "CS101");
+        }
+        cout << "  publish, no reader:   " << setw(6) << secondsSince(start) * 1e9 / publishes << " ns/change" << endl;
+    }
+    
+    {
+        ChangeFeed feed;
+        atomic<bool> done(false);
+        long long seen = 0, missed = 0;
+        thread reader([&]() {
+            unsigned long long cursor = 1;
+            ChangeRecord record;
+            while(true) {
+                ChangeFeed::ReadStatus status = feed.read(cursor, record);
+                if(status == ChangeFeed::READ_OK) {
+                    seen++;
+                    cursor++;
+                } else if(status == ChangeFeed::READ_OVERWRITTEN) {
+                    unsigned long long oldest = feed.oldestAvailable();
+                    missed += oldest - cursor;
+                    cursor = oldest;
+                } else if(done.load() && cursor > feed.lastSequence()) {
+                    break;
+                } else {
+                    this_thread::yield();
+                }
+            }
+        });
+        auto start = chrono::steady_clock::now();
+        for(int i = 0; i < publishes; i++) {
+            feed.publish(CHANGE_GRADE, 1000 + i, 7.5f, "CS101");
+        }
+        double seconds = secondsSince(start);
+        done.store(true);
+        reader.join();
+        cout << "  publish, with reader: " << setw(6) << seconds * 1e9 / publishes << " ns/change ("
+             << seen << " read, " << missed << " overwritten before read)" << endl;
+    }
+    
+    remove("students.dat");
+    generateDataset(count);
+    Database db;
+    db.setAutoSave(false);
+    int grades = 500000;
+    double off = timeGrades(db, count, grades, false);
+    double on = timeGrades(db, count, grades, true);
+    cout << "  grade update, feed off: " << setw(7) << off * 1e9 / grades << " ns" << endl;
+    cout << "  grade update, feed on:  " << setw(7) << on * 1e9 / grades << " ns ("
+         << (on - off) * 1e9 / grades << " ns per change)" << endl;
+}
+
+static void usage(const char* program) {
+    cout << "Usage: " << program << " <core|storage|pipeline|cache|shards|bulk|cdc> [students]" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    string mode = argv[1];
+    int count = argc > 2 ? atoi(argv[2]) : (mode == "storage" ? 1000000 : 20000);
+
+    mkdir(BENCH_DIR, 0755);
+    if(chdir(BENCH_DIR) != 0) {
+        cout << "Error: cannot enter " << BENCH_DIR << endl;
+        return 1;
+    }
+
+    if(mode == "core") {
+        benchCore(argc > 2 ? count : 200000);
+    } else if(mode == "storage") {
+        benchStorage(count);
+    } else if(mode == "pipeline") {
+        benchPipeline(count);
+    } else if(mode == "cache") {
+        benchCache(count);
+    } else if(mode == "cdc") {
+        benchChangeFeed(argc > 2 ? count : 100000);
+    } else if(mode == "bulk") {
+        benchBulk(argc > 2 ? count : 1000000);
+    } else if(mode == "shards") {
+        benchShards(argc > 2 ? count : 4000);
+    } else {
+        usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
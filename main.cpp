@@ -1,6 +1,16 @@
 #include <iostream>
 #include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <csignal>
+#include <sys/stat.h>
 #include "Database.h"
+#include "CommandPipeline.h"
+#include "Shard.h"
 
 using namespace std;
 
@@ -30,15 +40,234 @@ void displayMenu() {
     cout << "\n--- ENROLLMENT OPERATIONS ---" << endl;
     cout << "9. Enroll Student in Course" << endl;
     cout << "10. Add Grade to Student" << endl;
+    cout << "11. Course Report" << endl;
     
     cout << "\n0. Exit" << endl;
     cout << "\nEnter your choice: ";
 }
 
-int main() {
-    Database db;
+// Function to show command line usage
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--compressed|--text] [--cache-mb N] [--bulk-load FILE] [--script FILE]... [--fifo PATH]... [--stdin] [--workers N]" << endl;
+    cout << "       " << program << " --shards N [--shard-port PORT] [--partition hash|FIRST-LAST] [sources...]" << endl;
+    cout << "       " << program << " --shard-server PORT DIR [--compressed]" << endl;
+    cout << "       " << program << " --tail-changes FILE [--from SEQ]" << endl;
+    cout << "Add --changes FILE to append every change to FILE (or a FIFO)." << endl;
+    cout << "With no input sources the interactive menu is started." << endl;
+}
+
+// Run scripted commands through the pipeline and report throughput
+void runPipeline(CommandExecutor& executor, const vector<string>& sources, int workers) {
+    CommandPipeline pipeline(executor, workers);
+    for(size_t i = 0; i < sources.size(); i++) {
+        pipeline.addSource(sources[i]);
+    }
+    
+    auto start = chrono::steady_clock::now();
+    long long count = pipeline.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    cerr << "Processed " << count << " commands in " << seconds << " s";
+    if(seconds > 0) {
+        cerr << " (" << (long long)(count / seconds) << " commands/sec)";
+    }
+    cerr << endl;
+}
+
+// Load students.txt-style records through the bulk path and save once
+int runBulkLoad(Database& db, string filename) {
+    ifstream file(filename.c_str());
+    if(!file.is_open()) {
+        cout << "Error: cannot open " << filename << endl;
+        return 1;
+    }
+    
+    const size_t batchSize = 100000;
+    vector<Student> batch;
+    batch.reserve(batchSize);
+    long long records = 0, added = 0;
+    
+    auto start = chrono::steady_clock::now();
+    string line;
+    while(getline(file, line)) {
+        if(line.empty()) {
+            continue;
+        }
+        Student s;
+        s.deserialize(line);
+        batch.push_back(s);
+        records++;
+        if(batch.size() == batchSize) {
+            added += db.bulkAddStudents(batch, false);
+            batch.clear();
+        }
+    }
+    added += db.bulkAddStudents(batch, false);
+    db.finishBulkLoad();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    cout << "Bulk loaded " << added << " of " << records << " students ("
+         << records - added << " skipped as duplicates or invalid) in " << seconds << " s" << endl;
+    return 0;
+}
+
+// Start local shard processes and route scripted commands to them
+int runSharded(int shardCount, int basePort, string partition, bool compressed,
+               vector<string> sources, int workers) {
+    vector<pid_t> pids;
+    for(int i = 0; i < shardCount; i++) {
+        pid_t pid = spawnShard(basePort + i, "shard_" + to_string(i), compressed);
+        if(pid < 0) {
+            cout << "Error: could not start shard on port " << basePort + i << endl;
+            stopShards(pids);
+            return 1;
+        }
+        pids.push_back(pid);
+    }
+    
+    int status = 0;
+    {
+        ShardRouter router;
+        if(partition != "hash") {
+            long long first, last;
+            char dash;
+            istringstream range(partition);
+            if(!(range >> first >> dash >> last) || dash != '-' || last < first) {
+                cout << "Invalid partition: " << partition << endl;
+                stopShards(pids);
+                return 1;
+            }
+            router.setRangePartition(first, last);
+        }
+        
+        for(int i = 0; i < shardCount; i++) {
+            if(!router.connectShard("127.0.0.1", basePort + i)) {
+                cout << "Error: could not reach shard on port " << basePort + i << endl;
+                status = 1;
+                break;
+            }
+        }
+        
+        if(status == 0) {
+            if(sources.empty()) {
+                sources.push_back("-");
+            }
+            runPipeline(router, sources, workers);
+        }
+    }
+    
+    stopShards(pids);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
     int choice;
     
+    bool compressed = false;
+    bool text = false;
+    long long cacheMegabytes = -1;  // keep the default
+    vector<string> sources;
+    int workers = thread::hardware_concurrency();
+    int shardCount = 0;
+    int shardPort = 7600;
+    string partition = "hash";
+    string bulkFile;
+    string changeLog;
+    string tailLog;
+    unsigned long long tailFrom = 0;
+    
+    // Command line options
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--compressed") == 0) {
+            compressed = true;
+            text = false;
+        } else if(strcmp(argv[i], "--text") == 0) {
+            text = true;
+            compressed = false;
+        } else if(strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            sources.push_back(argv[++i]);
+        } else if(strcmp(argv[i], "--fifo") == 0 && i + 1 < argc) {
+            mkfifo(argv[i + 1], 0600);  // fails harmlessly if it already exists
+            sources.push_back(argv[++i]);
+        } else if(strcmp(argv[i], "--stdin") == 0) {
+            sources.push_back("-");
+        } else if(strcmp(argv[i], "--cache-mb") == 0 && i + 1 < argc) {
+            cacheMegabytes = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--bulk-load") == 0 && i + 1 < argc) {
+            bulkFile = argv[++i];
+        } else if(strcmp(argv[i], "--changes") == 0 && i + 1 < argc) {
+            changeLog = argv[++i];
+        } else if(strcmp(argv[i], "--tail-changes") == 0 && i + 1 < argc) {
+            tailLog = argv[++i];
+        } else if(strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            tailFrom = strtoull(argv[++i], nullptr, 10);
+        } else if(strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shardCount = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--shard-port") == 0 && i + 1 < argc) {
+            shardPort = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--partition") == 0 && i + 1 < argc) {
+            partition = argv[++i];
+        } else if(strcmp(argv[i], "--shard-server") == 0 && i + 2 < argc) {
+            int port = atoi(argv[i + 1]);
+            string dir = argv[i + 2];
+            bool shardCompressed = (i + 3 < argc && strcmp(argv[i + 3], "--compressed") == 0);
+            return runShardServer(port, dir, shardCompressed);
+        } else {
+            cout << "Unknown option: " << argv[i] << endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if(!tailLog.empty()) {
+        return tailChangeLog(tailLog, tailFrom);
+    }
+    
+    if(shardCount > 0) {
+        // These act on a single local Database, which the router does not have
+        const char* unsupported = !bulkFile.empty() ? "--bulk-load"
+                                : !changeLog.empty() ? "--changes"
+                                : cacheMegabytes >= 0 ? "--cache-mb" : nullptr;
+        if(unsupported) {
+            cout << "Error: " << unsupported << " cannot be combined with --shards" << endl;
+            return 1;
+        }
+        return runSharded(shardCount, shardPort, partition, compressed, sources, workers);
+    }
+    
+    Database db;
+    
+    // Switch storage format right away, so the files match the choice
+    // even if nothing else changes in this run
+    if((compressed || text) && compressed != db.isCompressedStorage()) {
+        db.setCompressedStorage(compressed);
+        db.saveToFile();
+    }
+    if(cacheMegabytes >= 0) {
+        db.setCacheBudget((size_t)cacheMegabytes * 1024 * 1024);
+    }
+    if(!changeLog.empty()) {
+        signal(SIGPIPE, SIG_IGN);  // a closed change log FIFO ends the sink only
+        db.getChangeFeed().startFileSink(changeLog);
+    }
+    
+    // A bulk load finishes the run unless commands are to follow
+    if(!bulkFile.empty()) {
+        int status = runBulkLoad(db, bulkFile);
+        if(status != 0 || sources.empty()) {
+            return status;
+        }
+    }
+    
+    if(!sources.empty()) {
+        LocalExecutor executor(db);
+        runPipeline(executor, sources, workers);
+        db.displayCacheStats(cerr);
+        return 0;
+    }
+    
     cout << "\n========================================" << endl;
     cout << "  Welcome to Student Management System  " << endl;
     cout << "========================================\n" << endl;
@@ -107,12 +336,7 @@ int main() {
                 cout << "Enter Roll Number to search: ";
                 cin >> rollNo;
                 
-                Student* s = db.searchStudent(rollNo);
-                if(s != nullptr) {
-                    s->displayInfo();
-                } else {
-                    cout << "Student not found!" << endl;
-                }
+                cout << db.renderStudent(rollNo);
                 break;
             }
             
@@ -195,6 +419,17 @@ int main() {
                 break;
             }
             
+            case 11: {
+                // Course Report
+                string code;
+                cout << "\n--- Course Report ---" << endl;
+                cout << "Enter Course Code: ";
+                cin >> code;
+                
+                cout << db.renderCourseReport(code);
+                break;
+            }
+            
             case 0: {
                 // Exit
                 cout << "\nThank you for using Student Management System!" << endl;
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+#include "Database.h"
+
+using namespace std;
+
+// Checks that cached student views and course reports follow every
+// mutation (make test)
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            cerr << "FAILED line " << __LINE__ << ": " #condition << endl; \
+            failures++; \
+        } \
+    } while(0)
+
+// The views built without the cache
+static string freshStudent(Database& db, int rollNo) {
+    Student* s = db.searchStudent(rollNo);
+    if(s == nullptr) {
+        return "Student not found!\n";
+    }
+    ostringstream out;
+    s->displayInfo(out);
+    return out.str();
+}
+
+static string freshReport(Database& db, string code) {
+    CourseStats stats;
+    if(!db.getCourseStats(code, stats)) {
+        return "Course not found!\n";
+    }
+    return Database::formatCourseReport(*db.searchCourse(code), stats);
+}
+
+static bool contains(const string& text, const string& part) {
+    return text.find(part) != string::npos;
+}
+
+// Every cached view must match a fresh one; rendering again re-caches them
+// for the next step
+#define CHECK_VIEWS(db) \
+    do { \
+        CHECK(db.renderStudent(1) == freshStudent(db, 1)); \
+        CHECK(db.renderStudent(2) == freshStudent(db, 2)); \
+        CHECK(db.renderCourseReport("CS101") == freshReport(db, "CS101")); \
+        CHECK(db.renderCourseReport("MA201") == freshReport(db, "MA201")); \
+    } while(0)
+
+static void testInvalidation() {
+    Database db;
+    db.setAutoSave(false);
+    db.addStudent(1, "Ann", 20);
+    db.addStudent(2, "Bob", 21);
+    db.addCourse("CS101", "Data Structures", 4);
+    db.addCourse("MA201", "Calculus", 3);
+    db.enrollStudentInCourse(1, "CS101");
+    db.addGradeToStudent(1, "CS101", 8);
+    CHECK_VIEWS(db);
+    CHECK_VIEWS(db);  // now served from the cache
+
+    db.updateStudentName(1, "Anna");
+    CHECK(contains(db.renderStudent(1), "Name: Anna"));
+    CHECK_VIEWS(db);
+
+    db.updateStudentAge(1, 22);
+    CHECK(contains(db.renderStudent(1), "Age: 22"));
+    CHECK_VIEWS(db);
+
+    db.enrollStudentInCourse(2, "CS101");
+    CHECK(contains(db.renderStudent(2), "CS101"));
+    CHECK(contains(db.renderCourseReport("CS101"), "Enrolled Students: 2"));
+    CHECK_VIEWS(db);
+
+    // A grade on another course changes the GPA shown in CS101's report
+    string before = db.renderCourseReport("CS101");
+    db.addGradeToStudent(1, "MA201", 4);
+    CHECK(db.renderCourseReport("CS101") != before);
+    CHECK(contains(db.renderCourseReport("MA201"), "Graded Students: 1"));
+    CHECK_VIEWS(db);
+
+    db.deleteStudent(1);
+    CHECK(db.renderStudent(1) == "Student not found!\n");
+    CHECK(contains(db.renderCourseReport("CS101"), "Enrolled Students: 1"));
+    CHECK_VIEWS(db);
+
+    db.deleteCourse("MA201");
+    CHECK(db.renderCourseReport("MA201") == "Course not found!\n");
+    db.addCourse("MA201", "Linear Algebra", 3);
+    CHECK(contains(db.renderCourseReport("MA201"), "Linear Algebra"));
+    CHECK_VIEWS(db);
+}
+
+int main() {
+    // Run in a scratch directory so real data files are never touched
+    char dir[] = "/tmp/sms_test_XXXXXX";
+    if(mkdtemp(dir) == nullptr || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory" << endl;
+        return 1;
+    }
+
+    // Silence the database's messages
+    ofstream discard("/dev/null");
+    streambuf* console = cout.rdbuf(discard.rdbuf());
+    testInvalidation();
+    cout.rdbuf(console);
+
+    system((string("rm -rf ") + dir).c_str());
+    if(failures > 0) {
+        cout << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "All cache tests passed" << endl;
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <unistd.h>
+#include "ChangeFeed.h"
+#include "Database.h"
+
+using namespace std;
+
+// Checks for the change feed ring and its log sink (make test)
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            cerr << "FAILED line " << __LINE__ << ": " #condition << endl; \
+            failures++; \
+        } \
+    } while(0)
+
+static void testReadInOrder() {
+    ChangeFeed feed(16);
+    ChangeRecord record;
+    CHECK(feed.lastSequence() == 0);
+    CHECK(feed.read(1, record) == ChangeFeed::READ_NOT_YET);
+
+    feed.publish(CHANGE_GRADE, 1001, 8.5f, "CS101");
+    CHECK(feed.lastSequence() == 1);
+    CHECK(feed.read(1, record) == ChangeFeed::READ_OK);
+    CHECK(record.seq == 1);
+    CHECK(record.type == CHANGE_GRADE);
+    CHECK(record.rollNo == 1001);
+    CHECK(record.value == 8.5f);
+    CHECK(strcmp(record.code, "CS101") == 0);
+    CHECK(feed.read(2, record) == ChangeFeed::READ_NOT_YET);
+}
+
+// Slots are reused after a ring's worth of changes
+static void testWrapAround() {
+    ChangeFeed feed(16);
+    for(int i = 1; i <= 40; i++) {
+        feed.publish(CHANGE_ADD_STUDENT, i, 20, "");
+    }
+    ChangeRecord record;
+    CHECK(feed.oldestAvailable() == 25);
+    CHECK(feed.read(1, record) == ChangeFeed::READ_OVERWRITTEN);
+    CHECK(feed.read(24, record) == ChangeFeed::READ_OVERWRITTEN);
+    CHECK(feed.read(25, record) == ChangeFeed::READ_OK);
+    CHECK(record.seq == 25 && record.rollNo == 25);
+    CHECK(feed.read(40, record) == ChangeFeed::READ_OK);
+    CHECK(record.seq == 40 && record.rollNo == 40);
+    CHECK(feed.read(41, record) == ChangeFeed::READ_NOT_YET);
+}
+
+// Numbering resumed from an earlier run: nothing before it is readable
+static void testResumedNumbering() {
+    ChangeFeed feed(16);
+    feed.setNextSequence(101);
+    ChangeRecord record;
+    CHECK(feed.lastSequence() == 100);
+    CHECK(feed.oldestAvailable() == 101);
+    CHECK(feed.read(100, record) == ChangeFeed::READ_OVERWRITTEN);
+    CHECK(feed.read(101, record) == ChangeFeed::READ_NOT_YET);
+
+    feed.publish(CHANGE_ADD_STUDENT, 7, 20, "");
+    CHECK(feed.oldestAvailable() == 101);
+    CHECK(feed.read(86, record) == ChangeFeed::READ_OVERWRITTEN);
+    CHECK(feed.read(101, record) == ChangeFeed::READ_OK);
+    CHECK(record.seq == 101 && record.rollNo == 7);
+
+    for(int i = 0; i < 40; i++) {
+        feed.publish(CHANGE_ADD_STUDENT, i, 20, "");
+    }
+    CHECK(feed.oldestAvailable() == 126);
+    CHECK(feed.read(126, record) == ChangeFeed::READ_OK);
+}
+
+static void testLineRoundTrip() {
+    ChangeRecord record;
+    memset(&record, 0, sizeof(record));
+    record.seq = 42;
+    record.type = CHANGE_GRADE;
+    record.rollNo = 1001;
+    record.value = 8.5f;
+    strcpy(record.code, "CS101");
+    CHECK(record.toLine() == "42 grade 1001 8.5 CS101");
+
+    ChangeRecord parsed;
+    CHECK(parsed.fromLine(record.toLine()));
+    CHECK(parsed.seq == 42 && parsed.type == CHANGE_GRADE && parsed.rollNo == 1001);
+    CHECK(parsed.value == 8.5f && strcmp(parsed.code, "CS101") == 0);
+
+    // No course code is written as "-"
+    record.type = CHANGE_DELETE_STUDENT;
+    record.code[0] = '\0';
+    CHECK(record.toLine() == "42 delete_student 1001 8.5 -");
+    CHECK(parsed.fromLine(record.toLine()));
+    CHECK(parsed.type == CHANGE_DELETE_STUDENT && parsed.code[0] == '\0');
+
+    // The longest course code allowed is carried whole
+    string longest(Course::MAX_CODE_LENGTH, 'C');
+    strcpy(record.code, longest.c_str());
+    CHECK(parsed.fromLine(record.toLine()));
+    CHECK(parsed.code == longest);
+
+    CHECK(!parsed.fromLine("42 rename 1001 0 -"));
+    CHECK(!parsed.fromLine("# missed 1-5"));
+}
+
+// Codes the feed could not carry whole are refused before any change
+static void testLongCourseCode() {
+    Database db;
+    db.setAutoSave(false);
+    ostringstream messages;
+    string tooLong(Course::MAX_CODE_LENGTH + 1, 'C');
+    db.addCourse(tooLong, "Too Long", 3, messages);
+    CHECK(db.searchCourse(tooLong) == nullptr);
+    CHECK(db.getChangeFeed().lastSequence() == 0);
+
+    db.addCourse(tooLong.substr(1), "Longest", 3, messages);
+    ChangeRecord record;
+    CHECK(db.getChangeFeed().read(1, record) == ChangeFeed::READ_OK);
+    CHECK(record.code == tooLong.substr(1));
+}
+
+static int countLines(const char* filename, unsigned long long& first, unsigned long long& last, bool& consecutive) {
+    ifstream log(filename);
+    string line;
+    int count = 0;
+    consecutive = true;
+    while(getline(log, line)) {
+        ChangeRecord record;
+        if(!record.fromLine(line)) {
+            consecutive = false;  // e.g. a "# missed" line
+            continue;
+        }
+        if(count == 0) {
+            first = record.seq;
+        } else if(record.seq != last + 1) {
+            consecutive = false;
+        }
+        last = record.seq;
+        count++;
+    }
+    return count;
+}
+
+// The log gets every change even when far more than a ring's worth are
+// published at once, and a second run continues its numbering
+static void testFileSink() {
+    {
+        ChangeFeed feed(16);
+        CHECK(feed.startFileSink("changes.log"));
+        for(int i = 0; i < 5000; i++) {
+            feed.publish(CHANGE_ADD_STUDENT, i, 20, "");
+        }
+        feed.stopFileSink();
+    }
+    unsigned long long first = 0, last = 0;
+    bool consecutive;
+    CHECK(countLines("changes.log", first, last, consecutive) == 5000);
+    CHECK(first == 1 && last == 5000 && consecutive);
+
+    {
+        ChangeFeed feed(16);
+        CHECK(feed.startFileSink("changes.log"));
+        CHECK(feed.oldestAvailable() == 5001);
+        feed.publish(CHANGE_DELETE_STUDENT, 3, 0, "");
+    }
+    CHECK(countLines("changes.log", first, last, consecutive) == 5001);
+    CHECK(last == 5001 && consecutive);
+    remove("changes.log");
+}
+
+int main() {
+    // Run in a scratch directory so real data files are never touched
+    char dir[] = "/tmp/sms_test_XXXXXX";
+    if(mkdtemp(dir) == nullptr || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory" << endl;
+        return 1;
+    }
+
+    testReadInOrder();
+    testWrapAround();
+    testResumedNumbering();
+    testLineRoundTrip();
+    testLongCourseCode();
+    testFileSink();
+
+    system((string("rm -rf ") + dir).c_str());
+    if(failures > 0) {
+        cout << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "All change feed tests passed" << endl;
+    return 0;
+}
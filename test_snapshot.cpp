@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Database.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+// Checks for the compressed snapshot format (make test)
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            cerr << "FAILED line " << __LINE__ << ": " #condition << endl; \
+            failures++; \
+        } \
+    } while(0)
+
+static vector<Student> makeStudents(int count) {
+    vector<Student> students;
+    for(int i = 0; i < count; i++) {
+        Student s(1000 + i * 3, "Student " + to_string(i), 18 + i % 7);
+        vector<string> courses;
+        courses.push_back("CS10" + to_string(i % 5));
+        courses.push_back("MATH20" + to_string(i % 3));
+        s.setCourses(courses);
+        map<string, float> grades;
+        grades[courses[0]] = (i % 41) / 4.0f;
+        s.setGrades(grades);
+        students.push_back(s);
+    }
+    return students;
+}
+
+static long long fileSize(const char* filename) {
+    struct stat info;
+    return stat(filename, &info) == 0 ? info.st_size : -1;
+}
+
+static bool fileExists(const char* filename) {
+    return fileSize(filename) >= 0;
+}
+
+static void testRoundTrip() {
+    vector<Student> original = makeStudents(20000);
+    CHECK(Snapshot::save(original, "students.dat"));
+    CHECK(!fileExists("students.dat.tmp"));
+
+    vector<Student> loaded;
+    CHECK(Snapshot::load("students.dat", loaded));
+    CHECK(loaded.size() == original.size());
+    for(size_t i = 0; i < loaded.size() && i < original.size(); i++) {
+        if(loaded[i].serialize() != original[i].serialize()) {
+            CHECK(loaded[i].serialize() == original[i].serialize());
+            break;
+        }
+    }
+}
+
+static void testTruncatedSnapshot() {
+    vector<Student> original = makeStudents(20000);
+    Snapshot::save(original, "students.dat");
+    CHECK(truncate("students.dat", fileSize("students.dat") - 10) == 0);
+
+    // The reader keeps every whole block before the damage
+    vector<Student> loaded;
+    CHECK(!Snapshot::load("students.dat", loaded));
+    CHECK(loaded.size() > 0);
+    CHECK(loaded.size() < original.size());
+    for(size_t i = 0; i < loaded.size(); i++) {
+        if(loaded[i].serialize() != original[i].serialize()) {
+            CHECK(loaded[i].serialize() == original[i].serialize());
+            break;
+        }
+    }
+
+    // The database keeps those students, saves them to a new snapshot and
+    // never saves over the damaged file
+    long long damagedSize = fileSize("students.dat");
+    {
+        Database db;
+        CHECK(db.searchStudent(1000) != nullptr);
+        CHECK(fileSize("students.dat.damaged") == damagedSize);
+        CHECK(fileExists("students.dat"));
+    }
+
+    // Reloading with no change in between still finds them
+    {
+        Database reloaded;
+        CHECK(reloaded.searchStudent(1000) != nullptr);
+        CHECK(reloaded.searchStudent(1000 + 3 * (int)(loaded.size() - 1)) != nullptr);
+
+        reloaded.addStudent(1, "New Student", 20);
+        CHECK(fileSize("students.dat.damaged") == damagedSize);
+    }
+
+    Database reloaded;
+    CHECK(reloaded.searchStudent(1) != nullptr);
+    CHECK(reloaded.searchStudent(1000) != nullptr);
+    remove("students.dat");
+    remove("students.dat.damaged");
+}
+
+static void putVarint(string& out, unsigned long long value) {
+    while(value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+// A good snapshot followed by a block header with impossible sizes must be
+// reported as damaged (keeping the good block), not crash on allocation
+static void testCorruptBlockSizes() {
+    const unsigned long long sizes[][2] = {
+        {1ULL << 62, 10},   // raw size far beyond any block
+        {1000, 1ULL << 40}  // packed size beyond the end of the file
+    };
+    for(int c = 0; c < 2; c++) {
+        vector<Student> original = makeStudents(100);
+        Snapshot::save(original, "students.dat");
+        string header;
+        putVarint(header, sizes[c][0]);
+        putVarint(header, sizes[c][1]);
+        ofstream file("students.dat", ios::binary | ios::app);
+        file << header << string(10, 'x');
+        file.close();
+
+        vector<Student> loaded;
+        CHECK(!Snapshot::load("students.dat", loaded));
+        CHECK(loaded.size() == original.size());
+
+        {
+            Database db;
+            CHECK(db.searchStudent(1000) != nullptr);
+            CHECK(fileExists("students.dat.damaged"));
+        }
+        remove("students.dat");
+        remove("students.dat.damaged");
+    }
+}
+
+static void testBackToText() {
+    Snapshot::save(makeStudents(10), "students.dat");
+    {
+        Database db;
+        CHECK(db.isCompressedStorage());
+        db.setCompressedStorage(false);
+        db.saveToFile();
+    }
+    CHECK(!fileExists("students.dat"));
+    CHECK(fileExists("students.txt"));
+
+    Database db;
+    CHECK(!db.isCompressedStorage());
+    CHECK(db.searchStudent(1000 + 9 * 3) != nullptr);
+    remove("students.txt");
+}
+
+int main() {
+    // Run in a scratch directory so real data files are never touched
+    char dir[] = "/tmp/sms_test_XXXXXX";
+    if(mkdtemp(dir) == nullptr || chdir(dir) != 0) {
+        cout << "Cannot create a scratch directory" << endl;
+        return 1;
+    }
+
+    // Silence the database's messages
+    ofstream discard("/dev/null");
+    streambuf* console = cout.rdbuf(discard.rdbuf());
+    testRoundTrip();
+    testTruncatedSnapshot();
+    testCorruptBlockSizes();
+    testBackToText();
+    cout.rdbuf(console);
+
+    system((string("rm -rf ") + dir).c_str());
+    if(failures > 0) {
+        cout << failures << " check(s) failed" << endl;
+        return 1;
+    }
+    cout << "All snapshot tests passed" << endl;
+    return 0;
+}